@@ -0,0 +1,162 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(__AVX__)
+#include <immintrin.h>
+#define AABB_BATCH_AVX
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AABB_BATCH_SSE
+#endif
+
+/*
+NOTE: Collision mostly asks one question over and over: which of these few boxes does this one box overlap, and by how much.
+Asking SDL one pair at a time means a function call, null checks and a couple of branches per pair. AabbBatch keeps the
+candidates as separate x / y / w / h arrays instead, so test() can check 8 of them at once with AVX or 4 with SSE, and
+falls back to a plain loop on anything else. Which one is used is decided at compile time (SDL3_DEMO_AVX2 in CMake).
+The math is the same as SDL_GetRectIntersectionFloat step by step, so the results are bit for bit what calling it for
+every pair gives: boxes that only touch count as overlapping (with a zero depth), boxes with a negative size never do.
+The arrays only grow, a batch that gets cleared and refilled every tick stops allocating after the first few.
+*/
+class AabbBatch
+{
+public:
+	static const size_t LANES = 8; // arrays are padded to this so the vector loops never read past the end
+
+#if defined(AABB_BATCH_AVX)
+	static constexpr const char* KERNEL = "avx";
+#elif defined(AABB_BATCH_SSE)
+	static constexpr const char* KERNEL = "sse";
+#else
+	static constexpr const char* KERNEL = "scalar";
+#endif
+
+private:
+	std::vector<float> x, y, w, h; // the candidates
+	std::vector<float> hitX, hitY, hitW, hitH; // intersection of each candidate with the last tested box
+	std::vector<uint32_t> mask; // bit i % 32 of mask[i / 32] is set if candidate i overlapped the last tested box
+	size_t count = 0;
+
+	// overlap test and intersection for candidates [i, i + 8), returns their bits
+	uint32_t testLanes(const SDL_FRect& box, size_t i)
+	{
+#if defined(AABB_BATCH_AVX)
+		const __m256 ax0 = _mm256_set1_ps(box.x), ax1 = _mm256_set1_ps(box.x + box.w);
+		const __m256 ay0 = _mm256_set1_ps(box.y), ay1 = _mm256_set1_ps(box.y + box.h);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 bx0 = _mm256_loadu_ps(&x[i]), by0 = _mm256_loadu_ps(&y[i]);
+		const __m256 bw = _mm256_loadu_ps(&w[i]), bh = _mm256_loadu_ps(&h[i]);
+		// argument order matters for equal values (+0 / -0), it matches SDL keeping the first box's edge on a tie
+		const __m256 x0 = _mm256_max_ps(bx0, ax0), x1 = _mm256_min_ps(_mm256_add_ps(bx0, bw), ax1);
+		const __m256 y0 = _mm256_max_ps(by0, ay0), y1 = _mm256_min_ps(_mm256_add_ps(by0, bh), ay1);
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(x1, x0, _CMP_NLT_UQ), _mm256_cmp_ps(y1, y0, _CMP_NLT_UQ));
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(bw, zero, _CMP_NLT_UQ), _mm256_cmp_ps(bh, zero, _CMP_NLT_UQ)));
+		_mm256_storeu_ps(&hitX[i], x0);
+		_mm256_storeu_ps(&hitY[i], y0);
+		_mm256_storeu_ps(&hitW[i], _mm256_sub_ps(x1, x0));
+		_mm256_storeu_ps(&hitH[i], _mm256_sub_ps(y1, y0));
+		return static_cast<uint32_t>(_mm256_movemask_ps(hit));
+#elif defined(AABB_BATCH_SSE)
+		const __m128 ax0 = _mm_set1_ps(box.x), ax1 = _mm_set1_ps(box.x + box.w);
+		const __m128 ay0 = _mm_set1_ps(box.y), ay1 = _mm_set1_ps(box.y + box.h);
+		const __m128 zero = _mm_setzero_ps();
+		uint32_t bits = 0;
+		for (size_t half = 0; half < 2; half++, i += 4)
+		{
+			const __m128 bx0 = _mm_loadu_ps(&x[i]), by0 = _mm_loadu_ps(&y[i]);
+			const __m128 bw = _mm_loadu_ps(&w[i]), bh = _mm_loadu_ps(&h[i]);
+			const __m128 x0 = _mm_max_ps(bx0, ax0), x1 = _mm_min_ps(_mm_add_ps(bx0, bw), ax1);
+			const __m128 y0 = _mm_max_ps(by0, ay0), y1 = _mm_min_ps(_mm_add_ps(by0, bh), ay1);
+			__m128 hit = _mm_and_ps(_mm_cmpnlt_ps(x1, x0), _mm_cmpnlt_ps(y1, y0));
+			hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpnlt_ps(bw, zero), _mm_cmpnlt_ps(bh, zero)));
+			_mm_storeu_ps(&hitX[i], x0);
+			_mm_storeu_ps(&hitY[i], y0);
+			_mm_storeu_ps(&hitW[i], _mm_sub_ps(x1, x0));
+			_mm_storeu_ps(&hitH[i], _mm_sub_ps(y1, y0));
+			bits |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << (half * 4);
+		}
+		return bits;
+#else
+		uint32_t bits = 0;
+		for (size_t lane = 0; lane < LANES; lane++, i++)
+		{
+			const float bx1 = x[i] + w[i], by1 = y[i] + h[i];
+			const float x0 = x[i] > box.x ? x[i] : box.x, x1 = bx1 < box.x + box.w ? bx1 : box.x + box.w;
+			const float y0 = y[i] > box.y ? y[i] : box.y, y1 = by1 < box.y + box.h ? by1 : box.y + box.h;
+			hitX[i] = x0;
+			hitY[i] = y0;
+			hitW[i] = x1 - x0;
+			hitH[i] = y1 - y0;
+			if (!(x1 < x0) && !(y1 < y0) && !(w[i] < 0) && !(h[i] < 0))
+			{
+				bits |= 1u << lane;
+			}
+		}
+		return bits;
+#endif
+	}
+
+public:
+	void clear() { count = 0; }
+	size_t size() const { return count; }
+
+	void push(const SDL_FRect& rect)
+	{
+		if (count == x.size())
+		{
+			const size_t padded = x.size() + LANES;
+			for (std::vector<float>* v : { &x, &y, &w, &h, &hitX, &hitY, &hitW, &hitH })
+			{
+				v->resize(padded, 0.0f);
+			}
+			mask.resize((padded + 31) / 32, 0);
+		}
+		x[count] = rect.x;
+		y[count] = rect.y;
+		w[count] = rect.w;
+		h[count] = rect.h;
+		count++;
+	}
+	SDL_FRect rect(size_t i) const { return SDL_FRect{ x[i], y[i], w[i], h[i] }; }
+
+	// tests box against every candidate and returns how many it overlaps, see hit() / intersection() for which ones
+	size_t test(const SDL_FRect& box)
+	{
+		const bool empty = box.w < 0 || box.h < 0; // SDL doesn't let an empty box overlap anything either
+		size_t hits = 0;
+		for (size_t i = 0; i < count; i += LANES)
+		{
+			uint32_t bits = empty ? 0 : testLanes(box, i);
+			if (count - i < LANES)
+			{
+				bits &= (1u << (count - i)) - 1; // whatever sits in the padding after the last candidate
+			}
+			uint32_t& word = mask[i / 32];
+			const uint32_t shift = static_cast<uint32_t>(i % 32);
+			word = (word & ~(0xFFu << shift)) | (bits << shift);
+			hits += std::popcount(bits);
+		}
+		return hits;
+	}
+	bool hit(size_t i) const { return (mask[i / 32] >> (i % 32)) & 1; }
+	// first candidate at or after i the last tested box overlapped, size() if there is none
+	size_t nextHit(size_t i) const
+	{
+		while (i < count)
+		{
+			const uint32_t word = mask[i / 32] >> (i % 32);
+			if (word)
+			{
+				return std::min(i + std::countr_zero(word), count);
+			}
+			i = (i / 32 + 1) * 32;
+		}
+		return count;
+	}
+	// overlap of the last tested box with candidate i, its w and h are how deep they are in each other
+	SDL_FRect intersection(size_t i) const { return SDL_FRect{ hitX[i], hitY[i], hitW[i], hitH[i] }; }
+};
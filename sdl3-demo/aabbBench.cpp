@@ -0,0 +1,165 @@
+// aabbBench.cpp : Times AabbBatch::test() against asking SDL one pair at a time, and checks both give the same answers.
+//
+// usage: sdl3-aabb-bench [--queries N] [--seed N]
+
+#include "aabbBatch.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// candidates per batch, from what a character's tile neighbourhood gives up to a crowded grid cell
+static const size_t CANDIDATE_COUNTS[] = { 4, 8, 16, 32, 64, 256, 1024 };
+static const size_t TESTS_PER_RUN = 4000000; // box tests per measurement, so small batches get enough repeats to time
+
+struct Scene
+{
+	std::vector<SDL_FRect> candidates;
+	std::vector<SDL_FRect> queries;
+};
+
+// tile sized and character sized boxes in a small area, so roughly half the tests hit. Some share edges to exercise
+// the touching case and a few have negative sizes
+static Scene makeScene(size_t candidates, size_t queries, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> pos(0.0f, 256.0f);
+	std::uniform_int_distribution<int> cell(0, 7);
+	std::uniform_real_distribution<float> size(4.0f, 48.0f);
+	std::uniform_int_distribution<int> kind(0, 9);
+	const auto makeBox = [&]()
+		{
+			switch (kind(rng))
+			{
+			case 0: // on the tile grid, edges line up with other grid boxes exactly
+				return SDL_FRect{ cell(rng) * 32.0f, cell(rng) * 32.0f, 32.0f, 32.0f };
+			case 1:
+				return SDL_FRect{ pos(rng), pos(rng), -size(rng), size(rng) };
+			default:
+				return SDL_FRect{ pos(rng), pos(rng), size(rng), size(rng) };
+			}
+		};
+	Scene scene;
+	for (size_t i = 0; i < candidates; i++)
+	{
+		scene.candidates.push_back(makeBox());
+	}
+	for (size_t i = 0; i < queries; i++)
+	{
+		scene.queries.push_back(makeBox());
+	}
+	return scene;
+}
+
+static double nsPerTest(uint64_t ticks, size_t tests)
+{
+	return ticks * 1e9 / SDL_GetPerformanceFrequency() / tests;
+}
+
+int main(int argc, char* argv[])
+{
+	size_t queryCount = 256;
+	unsigned seed = 1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--queries") == 0) queryCount = std::strtoul(argv[i + 1], nullptr, 10);
+		else if (std::strcmp(argv[i], "--seed") == 0) seed = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+		else
+		{
+			std::printf("usage: sdl3-aabb-bench [--queries N] [--seed N]\n");
+			return 1;
+		}
+	}
+	if (queryCount == 0)
+	{
+		queryCount = 1;
+	}
+
+	std::mt19937 rng(seed);
+	std::printf("kernel: %s\n", AabbBatch::KERNEL);
+	std::printf("%10s %14s %14s %14s %10s\n", "candidates", "SDL has ns", "SDL get ns", "batch ns", "speedup");
+	bool allMatch = true;
+	for (size_t candidates : CANDIDATE_COUNTS)
+	{
+		const Scene scene = makeScene(candidates, queryCount, rng);
+		AabbBatch batch;
+		for (const SDL_FRect& rect : scene.candidates)
+		{
+			batch.push(rect);
+		}
+		const size_t runs = std::max<size_t>(1, TESTS_PER_RUN / (candidates * scene.queries.size()));
+		const size_t tests = runs * candidates * scene.queries.size();
+		size_t hitsHas = 0, hitsGet = 0, hitsBatch = 0;
+		float depthGet = 0, depthBatch = 0; // summed so the compiler can't skip computing the intersections
+
+		uint64_t start = SDL_GetPerformanceCounter();
+		for (size_t run = 0; run < runs; run++)
+		{
+			for (const SDL_FRect& query : scene.queries)
+			{
+				for (const SDL_FRect& rect : scene.candidates)
+				{
+					hitsHas += SDL_HasRectIntersectionFloat(&query, &rect);
+				}
+			}
+		}
+		const uint64_t hasTicks = SDL_GetPerformanceCounter() - start;
+
+		start = SDL_GetPerformanceCounter();
+		for (size_t run = 0; run < runs; run++)
+		{
+			for (const SDL_FRect& query : scene.queries)
+			{
+				for (const SDL_FRect& rect : scene.candidates)
+				{
+					SDL_FRect overlap;
+					if (SDL_GetRectIntersectionFloat(&query, &rect, &overlap))
+					{
+						hitsGet++;
+						depthGet += overlap.w + overlap.h;
+					}
+				}
+			}
+		}
+		const uint64_t getTicks = SDL_GetPerformanceCounter() - start;
+
+		start = SDL_GetPerformanceCounter();
+		for (size_t run = 0; run < runs; run++)
+		{
+			for (const SDL_FRect& query : scene.queries)
+			{
+				hitsBatch += batch.test(query);
+				for (size_t k = batch.nextHit(0); k < batch.size(); k = batch.nextHit(k + 1))
+				{
+					const SDL_FRect overlap = batch.intersection(k);
+					depthBatch += overlap.w + overlap.h;
+				}
+			}
+		}
+		const uint64_t batchTicks = SDL_GetPerformanceCounter() - start;
+
+		// every answer has to be exactly what SDL says, the simulation depends on it being deterministic
+		bool match = hitsHas == hitsGet && hitsGet == hitsBatch && depthGet == depthBatch;
+		for (const SDL_FRect& query : scene.queries)
+		{
+			batch.test(query);
+			for (size_t k = 0; k < scene.candidates.size(); k++)
+			{
+				SDL_FRect overlap;
+				const bool hit = SDL_GetRectIntersectionFloat(&query, &scene.candidates[k], &overlap);
+				const SDL_FRect batchOverlap = batch.intersection(k);
+				if (hit != batch.hit(k) || (hit && std::memcmp(&overlap, &batchOverlap, sizeof(overlap)) != 0))
+				{
+					match = false;
+				}
+			}
+		}
+		allMatch = allMatch && match;
+
+		std::printf("%10zu %14.2f %14.2f %14.2f %9.1fx%s\n", candidates, nsPerTest(hasTicks, tests), nsPerTest(getTicks, tests),
+			nsPerTest(batchTicks, tests), static_cast<double>(getTicks) / std::max<uint64_t>(batchTicks, 1), match ? "" : "  MISMATCH");
+	}
+	std::printf("ns are per box pair, speedup is the batch against SDL_GetRectIntersectionFloat\n");
+	return allMatch ? 0 : 1;
+}
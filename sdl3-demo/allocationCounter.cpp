@@ -0,0 +1,65 @@
+// allocationCounter.cpp : Global operator new / delete that count allocations, see allocationCounter.h.
+//
+
+#include "allocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocations{ 0 };
+
+uint64_t heapAllocationCount()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
+
+static void* allocate(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+static void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+	void* p = _aligned_malloc(size ? size : 1, align);
+#else
+	// aligned_alloc wants the size to be a multiple of the alignment
+	void* p = std::aligned_alloc(align, ((size ? size : 1) + align - 1) / align * align);
+#endif
+	if (!p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+static void freeAligned(void* p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+// the array and nothrow versions the standard library provides end up in these
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { freeAligned(p); }
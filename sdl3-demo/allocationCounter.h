@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+
+/*
+NOTE: A frame that allocates is a frame that can hitch, the allocator takes locks and sometimes asks the OS for memory.
+allocationCounter.cpp replaces the global operator new and delete with versions that count every allocation before handing
+it to malloc, so the game and sdl3-headless can show how many allocations a frame or tick made. Once everything is warmed
+up that number should stay at 0. Memory SDL allocates for itself goes through SDL_malloc and isn't counted.
+*/
+
+// operator new calls on any thread since the program started
+uint64_t heapAllocationCount();
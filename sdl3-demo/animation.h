@@ -1,35 +1,44 @@
 #pragma once
-#include "timer.h"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <vector>
 
-class Animation
+/*
+NOTE: Every entity used to carry its own copy of every animation it could play, timers included, so spawning a bullet
+copied a vector and drawing worked the frame rectangle out with divides every time.
+A clip only describes a sequence of frames, which never changes after startup, so Resources::clips holds one of each and
+everything playing it shares it. The source rect of each frame is worked out once when the clip is made. All an entity
+keeps is which clip it plays and how far into it it is (AnimationState in gameObject.h).
+*/
+class AnimationClip
 {
-	Timer timer;
-	int frameCount; // number of animation frames in a animation
-	int startFrame;
-	int rowIndex;
-	int framesPerRow;
+	std::vector<SDL_FRect> frames; // source rect of every frame, relative to the sprite's atlas region
+	float length;
+	float framesPerSecond;
+
 public:
-	Animation() : timer(0), frameCount(0), startFrame(0), rowIndex(0) {}
-	Animation(int frameCount, float length, int startFrame, int rowIndex, int framesPerRow = 8) : frameCount(frameCount), timer(length), startFrame(startFrame), rowIndex(rowIndex), framesPerRow(framesPerRow)
+	// frames are frameWidth x frameHeight cells of a sprite sheet, the clip plays frameCount of them left to right starting
+	// at column startFrame of row rowIndex
+	AnimationClip(int frameCount, float length, int startFrame, int rowIndex, float frameWidth, float frameHeight)
+		: length(length), framesPerSecond(frameCount / length)
 	{
+		for (int i = 0; i < frameCount; i++)
+		{
+			frames.push_back(SDL_FRect{
+				.x = (startFrame + i) * frameWidth,
+				.y = rowIndex * frameHeight,
+				.w = frameWidth,
+				.h = frameHeight
+			});
+		}
 	}
 
-	float getLength() const { return timer.getlength(); }
-	float getRowIndex() const { return rowIndex; }
-
-	// used to calculate current frame we need to display for the sprite
-	int currentFrame() const
-	{
-		// time value / time length value = % of beginning to end of animation
-		// we then must multiply by frameCount to get the frame we need to display on screen
-		return static_cast<int>(timer.getTime() / timer.getlength() * frameCount);
-	}
-	void step(float deltaTime)
-	{
-		timer.step(deltaTime);
-	}
-	void reset()
+	float getLength() const { return length; }
+	size_t frameCount() const { return frames.size(); }
+	// source rect of the frame showing time seconds into the clip, time has to be in [0, getLength())
+	const SDL_FRect& frameAt(float time) const
 	{
-		timer.reset();
+		const size_t frame = static_cast<size_t>(time * framesPerSecond);
+		return frames[std::min(frame, frames.size() - 1)];
 	}
-};
\ No newline at end of file
+};
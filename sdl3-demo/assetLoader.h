@@ -0,0 +1,142 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "textureCache.h"
+
+/*
+NOTE: Decoding a PNG (inflating it and unfiltering every row) is by far the slowest part of starting the game, and images
+don't depend on each other, so a few worker threads decode them at the same time. Workers only ever produce SDL_Surfaces
+in plain memory. Textures belong to the renderer, which may only be used from the main thread, so the main thread
+picks up finished surfaces with takeFinished() and uploads them itself while it keeps drawing a loading screen.
+Images that are in the texture cache skip decoding altogether, see textureCache.h.
+*/
+class AssetLoader
+{
+public:
+	struct Image
+	{
+		std::string path;
+		int padding; // edge pixels repeated around the image, see blitWithEdges in game.cpp
+		SDL_Surface* surface; // RGBA32, already padded, nullptr if decoding failed
+		double decodeSeconds;
+		std::unique_ptr<MappedFile> mapping; // holds the pixels of surface when it came from the cache
+		bool fromCache;
+	};
+
+private:
+	std::vector<Image> images;
+	std::vector<std::thread> workers;
+	std::atomic<size_t> nextImage{ 0 };
+	std::atomic<bool> cancelled{ false };
+	std::mutex finishedMutex;
+	std::vector<size_t> finished; // decoded but not taken by the main thread yet
+	size_t taken = 0;
+	uint64_t startCounter = 0;
+
+	void work()
+	{
+		const double counterFrequency = static_cast<double>(SDL_GetPerformanceFrequency());
+		for (size_t i = nextImage++; i < images.size() && !cancelled; i = nextImage++)
+		{
+			Image& image = images[i];
+			const uint64_t start = SDL_GetPerformanceCounter();
+			image.surface = decode(image);
+			image.decodeSeconds = (SDL_GetPerformanceCounter() - start) / counterFrequency;
+
+			std::lock_guard<std::mutex> lock(finishedMutex);
+			finished.push_back(i);
+		}
+	}
+
+public:
+	// loads the file and converts it to RGBA32 with padding pixels around it, safe to call from any thread
+	static SDL_Surface* decode(Image& image);
+
+	~AssetLoader()
+	{
+		cancel();
+	}
+
+	void start(const std::vector<std::string>& paths, int padding, unsigned threadCount = std::thread::hardware_concurrency())
+	{
+		cancel();
+		images.clear();
+		for (const std::string& path : paths)
+		{
+			images.push_back(Image{ path, padding, nullptr, 0, nullptr, false });
+		}
+		finished.clear();
+		taken = 0;
+		nextImage = 0;
+		cancelled = false;
+		startCounter = SDL_GetPerformanceCounter();
+		// leave one core for the main thread, it has uploading and a loading screen to take care of
+		const size_t count = std::clamp<size_t>(threadCount > 1 ? threadCount - 1 : 1, 1, std::max<size_t>(images.size(), 1));
+		for (size_t t = 0; t < count; t++)
+		{
+			workers.emplace_back(&AssetLoader::work, this);
+		}
+	}
+
+	// moves the indices of images decoded since the last call into out, the caller owns their surfaces from then on
+	void takeFinished(std::vector<size_t>& out)
+	{
+		out.clear();
+		std::lock_guard<std::mutex> lock(finishedMutex);
+		out.swap(finished);
+		taken += out.size();
+	}
+	Image& image(size_t i) { return images[i]; }
+	size_t imageCount() const { return images.size(); }
+	size_t takenCount() const { return taken; }
+	size_t cachedCount() const
+	{
+		size_t count = 0;
+		for (const Image& image : images)
+		{
+			count += image.fromCache;
+		}
+		return count;
+	}
+	bool isDone() const { return taken == images.size(); }
+	size_t threadCount() const { return workers.size(); }
+	double secondsSinceStart() const
+	{
+		return (SDL_GetPerformanceCounter() - startCounter) / static_cast<double>(SDL_GetPerformanceFrequency());
+	}
+
+	// waits for the workers, anything they didn't get to stays undecoded
+	void cancel()
+	{
+		cancelled = true;
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		workers.clear();
+		// surfaces that were never taken would leak otherwise
+		for (size_t i : finished)
+		{
+			SDL_DestroySurface(images[i].surface);
+			images[i].surface = nullptr;
+			images[i].mapping.reset();
+		}
+		finished.clear();
+	}
+	// workers are done once every image was taken, this just cleans up the threads
+	void finish()
+	{
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		workers.clear();
+	}
+};
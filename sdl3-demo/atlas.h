@@ -0,0 +1,94 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+// a picture inside an atlas page, everything that gets drawn refers to one of these instead of a whole texture
+struct AtlasRegion
+{
+	SDL_Texture* texture = nullptr;
+	SDL_FRect area{ 0, 0, 0, 0 }; // pixels of texture that belong to the picture
+
+	float width() const { return area.w; }
+	float height() const { return area.h; }
+};
+
+// where packAtlas put an image
+struct AtlasPlacement
+{
+	int page;
+	int x, y;
+};
+
+/*
+NOTE: Shelf packing. Images get sorted tallest first and are placed left to right along a shelf, when the next one doesn't
+fit anymore a new shelf is started under the tallest image of the last one, and when a page is full a new page is started.
+It wastes a bit of space on shelves with mixed heights, but for a handful of sprite sheets and tiles that doesn't matter
+and it only runs once at startup.
+Every image gets padding pixels around it so neighbours don't bleed into each other when sampling at the edges.
+pageSizes receives how much of each page actually got used, so pages can be allocated no bigger than needed.
+*/
+inline std::vector<AtlasPlacement> packAtlas(const std::vector<SDL_Point>& sizes, int pageSize, int padding, std::vector<SDL_Point>& pageSizes)
+{
+	struct Shelf
+	{
+		int y, height, x;
+	};
+	struct Page
+	{
+		std::vector<Shelf> shelves;
+		int nextY; // where the next shelf would start
+	};
+	std::vector<Page> pages;
+	std::vector<AtlasPlacement> placements(sizes.size());
+	pageSizes.clear();
+
+	std::vector<size_t> order(sizes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b)
+		{
+			return sizes[a].y != sizes[b].y ? sizes[a].y > sizes[b].y : sizes[a].x > sizes[b].x;
+		});
+
+	for (size_t i : order)
+	{
+		const int w = sizes[i].x + 2 * padding;
+		const int h = sizes[i].y + 2 * padding;
+		bool placed = false;
+		for (size_t p = 0; p < pages.size() && !placed; p++)
+		{
+			Page& page = pages[p];
+			// existing shelf with room left
+			for (Shelf& shelf : page.shelves)
+			{
+				if (h <= shelf.height && shelf.x + w <= pageSize)
+				{
+					placements[i] = AtlasPlacement{ static_cast<int>(p), shelf.x + padding, shelf.y + padding };
+					shelf.x += w;
+					placed = true;
+					break;
+				}
+			}
+			// new shelf under the last one
+			if (!placed && page.nextY + h <= pageSize && w <= pageSize)
+			{
+				page.shelves.push_back(Shelf{ page.nextY, h, w });
+				placements[i] = AtlasPlacement{ static_cast<int>(p), padding, page.nextY + padding };
+				page.nextY += h;
+				placed = true;
+			}
+		}
+		if (!placed)
+		{
+			// new page, an image bigger than a page gets a page of its own size
+			pages.push_back(Page{ { Shelf{ 0, h, w } }, h });
+			pageSizes.push_back(SDL_Point{ 0, 0 });
+			placements[i] = AtlasPlacement{ static_cast<int>(pages.size() - 1), padding, padding };
+		}
+		SDL_Point& used = pageSizes[placements[i].page];
+		used.x = std::max(used.x, placements[i].x + sizes[i].x + padding);
+		used.y = std::max(used.y, placements[i].y + sizes[i].y + padding);
+	}
+	return placements;
+}
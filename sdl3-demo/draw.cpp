@@ -0,0 +1,51 @@
+// draw.cpp : Drawing code shared by the game and the benchmarks.
+//
+
+#include "draw.h"
+
+void drawObject(const SDLState& state, GameState& gs, const Resources& res, SpriteBatch& batch, EntityStore& store, size_t i, float width, float height, float alpha)
+{
+	const Transform& transform = store.transform[i];
+	const AnimationState& anim = store.animation[i];
+	const Render& render = store.render[i];
+
+	// the clip knows where each of its frames sits in the sprite sheet, without one the top left corner gets drawn
+	const SDL_FRect src = anim.clip != -1
+		? res.clips[anim.clip].frameAt(anim.time)
+		: SDL_FRect{ 0, 0, width, height };
+
+	//destination of the sprite
+	const glm::vec2 position = glm::mix(transform.prevPosition, transform.position, alpha);
+	SDL_FRect dst{
+		.x = position.x - gs.mapViewport.x, //setting horizontal position of player in destination rect of drawing code
+		.y = position.y,
+		.w = width,
+		.h = height
+	};
+
+	SDL_FlipMode flipMode = transform.direction == -1 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+	batch.draw(res.sprites[render.sprite], src, dst, flipMode);
+}
+
+// as our player walks towards the right, the background moves towards the left relative to the movement speed of the character
+void scrollParalaxBackground(const AtlasRegion& sprite, float xVelocity, float& scrollPos, float scrollFactor, float deltaTime)
+{
+	scrollPos -= xVelocity * scrollFactor * deltaTime;
+	if (scrollPos <= -sprite.width())
+	{
+		scrollPos = 0;
+	}
+}
+
+void drawParalaxBackground(SDL_Renderer* renderer, const AtlasRegion& sprite, float x)
+{
+	SDL_FRect dst{
+		.x = x,
+		.y = 10,
+		.w = sprite.width() * 2.0f,
+		.h = sprite.height()
+
+	};
+	// tiling only repeats the region, not the rest of the atlas page
+	SDL_RenderTextureTiled(renderer, sprite.texture, &sprite.area, 1, &dst);
+}
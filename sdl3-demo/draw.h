@@ -0,0 +1,12 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include "game.h"
+#include "spriteBatch.h"
+
+// queues the sprite of entity i of store into batch, alpha blends between the position of the previous tick and the
+// current one so movement stays smooth between ticks
+void drawObject(const SDLState& state, GameState& gs, const Resources& res, SpriteBatch& batch, EntityStore& store, size_t i, float width, float height, float alpha);
+// moves scrollPos against the player's movement by scrollFactor, wrapping around after one width of sprite
+void scrollParalaxBackground(const AtlasRegion& sprite, float xVelocity, float& scrollPos, float scrollFactor, float deltaTime);
+// draws sprite twice side by side, the first one at x
+void drawParalaxBackground(SDL_Renderer* renderer, const AtlasRegion& sprite, float x);
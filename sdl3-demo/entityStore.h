@@ -0,0 +1,172 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "gameObject.h"
+
+/*
+Struct-of-arrays storage for one kind of entity (characters, bullets). Component i of every array belongs
+to the same entity and live entities are always packed into [0, size()), so loops can walk a single array front to back.
+Destroying an entity moves the last one into its place, Entity handles go through a slot table so they survive that move.
+*/
+class EntityStore
+{
+	struct Slot
+	{
+		uint32_t dense; // where the entity currently sits in the arrays
+		uint32_t generation; // bumped on destroy so stale handles stop resolving
+	};
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	std::vector<uint32_t> denseToSlot;
+	size_t count;
+	size_t maxCount;
+
+	void growArrays(size_t newSize)
+	{
+		type.resize(newSize, ObjectType::level);
+		data.resize(newSize);
+		transform.resize(newSize);
+		physics.resize(newSize);
+		collider.resize(newSize, SDL_FRect{ 0 });
+		animation.resize(newSize);
+		render.resize(newSize);
+		denseToSlot.resize(newSize);
+	}
+
+public:
+	std::vector<ObjectType> type;
+	std::vector<ObjectData> data;
+	std::vector<Transform> transform;
+	std::vector<Physics> physics;
+	std::vector<SDL_FRect> collider;
+	std::vector<AnimationState> animation;
+	std::vector<Render> render;
+
+	static const size_t UNLIMITED = SIZE_MAX;
+
+	// a store with a fixed capacity allocates everything up front and never touches the heap again
+	EntityStore(size_t capacity = UNLIMITED) : count(0), maxCount(capacity)
+	{
+		if (capacity != UNLIMITED)
+		{
+			growArrays(capacity);
+			slots.reserve(capacity);
+			freeSlots.reserve(capacity);
+		}
+	}
+
+	// returns an invalid handle (see isValid) when the store is full
+	// a recycled index still holds the components of whatever used it last, so the caller has to set every field
+	Entity create()
+	{
+		if (count == maxCount)
+		{
+			return Entity{ UINT32_MAX, 0 };
+		}
+		if (count == type.size())
+		{
+			growArrays(count == 0 ? 16 : count * 2);
+		}
+
+		uint32_t slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			slot = static_cast<uint32_t>(slots.size());
+			slots.push_back(Slot{ 0, 0 });
+		}
+		slots[slot].dense = static_cast<uint32_t>(count);
+		denseToSlot[count] = slot;
+		count++;
+		return Entity{ slot, slots[slot].generation };
+	}
+	void destroy(size_t index)
+	{
+		const size_t last = count - 1;
+		const uint32_t slot = denseToSlot[index];
+		if (index != last)
+		{
+			// components are plain data, the last entity is simply copied over the destroyed one
+			type[index] = type[last];
+			data[index] = data[last];
+			transform[index] = transform[last];
+			physics[index] = physics[last];
+			collider[index] = collider[last];
+			animation[index] = animation[last];
+			render[index] = render[last];
+			denseToSlot[index] = denseToSlot[last];
+			slots[denseToSlot[index]].dense = static_cast<uint32_t>(index);
+		}
+		slots[slot].generation++;
+		freeSlots.push_back(slot);
+		count--;
+	}
+
+	bool isValid(Entity e) const
+	{
+		return e.index < slots.size() && slots[e.index].generation == e.generation;
+	}
+	size_t indexOf(Entity e) const { return slots[e.index].dense; }
+	size_t indexOfSlot(uint32_t slot) const { return slots[slot].dense; }
+	Entity entityAt(size_t index) const { return Entity{ denseToSlot[index], slots[denseToSlot[index]].generation }; }
+	size_t size() const { return count; }
+	size_t capacity() const { return maxCount; }
+
+	// writes the live entities and the handle tables to a SnapshotWriter, see snapshot.h
+	template<typename Writer>
+	void capture(Writer& out) const
+	{
+		out.write(static_cast<uint32_t>(count));
+		out.write(static_cast<uint32_t>(slots.size()));
+		out.write(static_cast<uint32_t>(freeSlots.size()));
+		out.write(slots.data(), slots.size());
+		out.write(freeSlots.data(), freeSlots.size());
+		out.write(denseToSlot.data(), count);
+		out.write(type.data(), count);
+		out.write(data.data(), count);
+		out.write(transform.data(), count);
+		out.write(physics.data(), count);
+		out.write(collider.data(), count);
+		out.write(animation.data(), count);
+		out.write(render.data(), count);
+	}
+	// puts the store back the way capture() found it, handles taken back then resolve again. Returns false if the data
+	// doesn't fit into this store
+	template<typename Reader>
+	bool restore(Reader& in)
+	{
+		uint32_t newCount, slotCount, freeCount;
+		if (!in.read(newCount) || !in.read(slotCount) || !in.read(freeCount) ||
+			newCount > slotCount || freeCount > slotCount || slotCount > maxCount)
+		{
+			return false;
+		}
+		if (newCount > type.size())
+		{
+			growArrays(newCount);
+		}
+		slots.resize(slotCount);
+		freeSlots.resize(freeCount);
+		count = newCount;
+		return in.read(slots.data(), slotCount) && in.read(freeSlots.data(), freeCount) && in.read(denseToSlot.data(), count) &&
+			in.read(type.data(), count) && in.read(data.data(), count) && in.read(transform.data(), count) &&
+			in.read(physics.data(), count) && in.read(collider.data(), count) && in.read(animation.data(), count) &&
+			in.read(render.data(), count);
+	}
+
+	// world space hitbox of the entity at index
+	SDL_FRect worldCollider(size_t index) const
+	{
+		return SDL_FRect{
+			.x = transform[index].position.x + collider[index].x,
+			.y = transform[index].position.y + collider[index].y,
+			.w = collider[index].w,
+			.h = collider[index].h
+		};
+	}
+};
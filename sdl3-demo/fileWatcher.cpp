@@ -0,0 +1,140 @@
+// fileWatcher.cpp : Notices files changing on disk, with inotify on Linux and by polling elsewhere.
+//
+
+#include "fileWatcher.h"
+#include <algorithm>
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+static void reportOnce(std::vector<std::string>& changed, const std::string& path)
+{
+	if (std::find(changed.begin(), changed.end(), path) == changed.end())
+	{
+		changed.push_back(path);
+	}
+}
+
+#ifdef __linux__
+bool FileWatcher::add(const std::string& path)
+{
+	if (fd < 0)
+	{
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (fd < 0)
+		{
+			SDL_Log("Could not start watching files: %s", std::strerror(errno));
+			return false;
+		}
+		events.resize(64 * (sizeof(inotify_event) + 256));
+	}
+	File file;
+	file.path = path;
+	const size_t slash = path.find_last_of('/');
+	const std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+	file.name = slash == std::string::npos ? path : path.substr(slash + 1);
+	// watching a directory twice hands back the same watch, so files in one directory share it
+	file.watch = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (file.watch < 0)
+	{
+		SDL_Log("Could not watch %s: %s", directory.c_str(), std::strerror(errno));
+		return false;
+	}
+	files.push_back(std::move(file));
+	return true;
+}
+
+void FileWatcher::poll(std::vector<std::string>& changed)
+{
+	if (fd < 0)
+	{
+		return;
+	}
+	for (;;)
+	{
+		const ssize_t length = read(fd, events.data(), events.size());
+		if (length <= 0)
+		{
+			return; // EAGAIN, nothing more happened
+		}
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(events.data() + offset);
+			offset += sizeof(inotify_event) + event->len;
+			if (event->mask & IN_Q_OVERFLOW)
+			{
+				// events were lost, anything could have changed
+				for (const File& file : files)
+				{
+					reportOnce(changed, file.path);
+				}
+				continue;
+			}
+			if (!event->len)
+			{
+				continue;
+			}
+			for (const File& file : files)
+			{
+				if (file.watch == event->wd && file.name == event->name)
+				{
+					reportOnce(changed, file.path);
+				}
+			}
+		}
+	}
+}
+
+void FileWatcher::close()
+{
+	if (fd >= 0)
+	{
+		::close(fd); // takes every watch with it
+		fd = -1;
+	}
+	files.clear();
+}
+#else
+bool FileWatcher::add(const std::string& path)
+{
+	File file;
+	file.path = path;
+	SDL_PathInfo info;
+	if (!SDL_GetPathInfo(path.c_str(), &info))
+	{
+		SDL_Log("Could not watch %s: %s", path.c_str(), SDL_GetError());
+		return false;
+	}
+	file.modifyTime = info.modify_time;
+	files.push_back(std::move(file));
+	return true;
+}
+
+void FileWatcher::poll(std::vector<std::string>& changed)
+{
+	const uint64_t now = SDL_GetTicks();
+	if (now - lastPoll < POLL_INTERVAL_MS)
+	{
+		return;
+	}
+	lastPoll = now;
+	for (File& file : files)
+	{
+		// a file that is missing for a moment is probably being replaced, it shows up again with a new time
+		SDL_PathInfo info;
+		if (SDL_GetPathInfo(file.path.c_str(), &info) && info.modify_time != file.modifyTime)
+		{
+			file.modifyTime = info.modify_time;
+			reportOnce(changed, file.path);
+		}
+	}
+}
+
+void FileWatcher::close()
+{
+	files.clear();
+}
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <string>
+#include <vector>
+
+/*
+NOTE: Tells which of a handful of files changed on disk, so assets and levels can be reloaded while the game runs.
+On Linux it uses inotify, which costs one read() on a non blocking descriptor per poll() and nothing while no file
+changes. The directories are watched rather than the files themselves, because editors and our own tools save by
+writing a temporary file and renaming it over the old one. The renamed file is a new inode, and a watch on the old
+inode would never hear about it. Everywhere else poll() compares modification times with SDL_GetPathInfo every
+POLL_INTERVAL_MS, which is a few stat calls.
+A file is reported once per poll() however many events it got. With inotify that only happens after it was closed or
+renamed into place, so nobody reads a half written file.
+*/
+class FileWatcher
+{
+public:
+	static const uint64_t POLL_INTERVAL_MS = 500;
+
+private:
+	struct File
+	{
+		std::string path; // as passed to add(), which is what poll() hands back
+#ifdef __linux__
+		std::string name; // without the directory
+		int watch = -1; // inotify watch of its directory
+#else
+		SDL_Time modifyTime = 0;
+#endif
+	};
+	std::vector<File> files;
+#ifdef __linux__
+	int fd = -1;
+	std::vector<char> events; // read buffer
+#else
+	uint64_t lastPoll = 0;
+#endif
+
+public:
+	FileWatcher() = default;
+	~FileWatcher() { close(); }
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// starts watching path, returns false if that can't be done
+	bool add(const std::string& path);
+	// appends the watched files that changed since the last call to changed, never blocks
+	void poll(std::vector<std::string>& changed);
+	void close();
+};
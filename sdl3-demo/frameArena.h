@@ -0,0 +1,109 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+/*
+NOTE: Anything that only lives for one frame (text for the debug overlay, the list of what is visible, ...) used to get its
+memory from the heap and give it back a few lines later. FrameArena hands out memory by bumping an offset into one block and
+never frees anything on its own. The game calls reset() once a frame is done with it, which makes the whole block free again.
+If a frame wants more than the block holds the rest comes from the heap, and the next reset() replaces the block with
+one big enough for that frame, so after the first few frames nothing here touches the heap any more.
+It's a std::pmr::memory_resource, so the standard containers can use it through FrameVector / FrameString below. Only one
+thread may use frameArena() (the simulation thread in the game), and nothing allocated from it may be kept past reset().
+*/
+class FrameArena : public std::pmr::memory_resource
+{
+	std::byte* block = nullptr;
+	size_t capacity = 0;
+	size_t used = 0;
+	size_t overflowBytes = 0; // what didn't fit in the block this frame
+	size_t highWater = 0; // most bytes a frame has wanted so far
+	std::vector<std::pair<void*, size_t>> overflow; // heap blocks handed out after the block ran out, with their alignment
+
+public:
+	explicit FrameArena(size_t initialCapacity = 64 * 1024)
+	{
+		overflow.reserve(64);
+		grow(initialCapacity);
+	}
+	~FrameArena()
+	{
+		release();
+		::operator delete(block, std::align_val_t{ alignof(std::max_align_t) });
+	}
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// frees everything allocated since the last reset, call once per frame
+	void reset()
+	{
+		highWater = std::max(highWater, used + overflowBytes);
+		const bool overflowed = !overflow.empty();
+		release();
+		used = 0;
+		overflowBytes = 0;
+		if (overflowed)
+		{
+			grow(highWater + highWater / 2);
+		}
+	}
+
+	size_t bytesUsed() const { return used + overflowBytes; }
+	size_t getCapacity() const { return capacity; }
+	size_t getHighWater() const { return std::max(highWater, used + overflowBytes); }
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		const uintptr_t base = reinterpret_cast<uintptr_t>(block);
+		const uintptr_t start = (base + used + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+		if (start + bytes <= base + capacity)
+		{
+			used = start + bytes - base;
+			return reinterpret_cast<void*>(start);
+		}
+		void* p = ::operator new(bytes, std::align_val_t{ alignment });
+		overflow.emplace_back(p, alignment);
+		overflowBytes += bytes;
+		return p;
+	}
+
+	// memory only comes back all at once in reset()
+	void do_deallocate(void*, size_t, size_t) override {}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+private:
+	void grow(size_t newCapacity)
+	{
+		::operator delete(block, std::align_val_t{ alignof(std::max_align_t) });
+		block = static_cast<std::byte*>(::operator new(newCapacity, std::align_val_t{ alignof(std::max_align_t) }));
+		capacity = newCapacity;
+	}
+
+	void release()
+	{
+		for (const auto& [p, alignment] : overflow)
+		{
+			::operator delete(p, std::align_val_t{ alignment });
+		}
+		overflow.clear();
+	}
+};
+
+inline FrameArena& frameArena()
+{
+	static FrameArena instance;
+	return instance;
+}
+
+template<typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
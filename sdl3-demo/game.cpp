@@ -0,0 +1,1051 @@
+// game.cpp : Simulation code shared by the game and the headless benchmark.
+//
+
+#include "game.h"
+#include <algorithm>
+#include <cmath>
+
+// advances the whole game by one fixed tick
+void simulate(const SDLState& state, GameState& gs, Resources& res, float deltaTime)
+{
+	// remember where everything was so drawing can interpolate towards the new positions
+	savePreviousPositions(gs.characters);
+	savePreviousPositions(gs.bullets);
+	JobSystem& pool = jobs();
+	if (gs.scratch.size() != pool.threadCount())
+	{
+		gs.scratch.resize(pool.threadCount());
+	}
+
+	// update characters, level tiles never move so there is nothing to update for them
+	{
+		PROFILE_ZONE("update characters");
+		// the player reads input and spawns bullets, so it goes first on this thread. Everyone else only touches itself
+		const size_t player = gs.player();
+		update(state, gs, res, gs.characters, player, deltaTime);
+		pool.parallelFor(gs.characters.size(), SIM_GRAIN, [&](size_t begin, size_t end, size_t)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					if (i != player)
+					{
+						update(state, gs, res, gs.characters, i, deltaTime);
+					}
+				}
+			});
+	}
+
+	// update bullets
+	{
+		PROFILE_ZONE("update bullets");
+		pool.parallelFor(gs.bullets.size(), SIM_GRAIN, [&](size_t begin, size_t end, size_t)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					update(state, gs, res, gs.bullets, i, deltaTime);
+				}
+			});
+	}
+
+	// now that everything has moved, resolve what ran into what
+	{
+		PROFILE_ZONE("collision");
+		// tiles never move, so every character can be pushed out of them at the same time
+		pool.parallelFor(gs.characters.size(), SIM_GRAIN, [&](size_t begin, size_t end, size_t worker)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					resolveLevel(state, gs, res, gs.characters, i, gs.scratch[worker], deltaTime);
+				}
+			});
+		// the grid isn't thread safe and the contact passes need it to be up to date
+		for (size_t i = 0; i < gs.characters.size(); i++)
+		{
+			gs.grid.move(GameState::colliderId(gs.characters.entityAt(i)), gs.characters.worldCollider(i));
+		}
+		// bullets that already hit something or flew off the map stay where they are
+		pool.parallelFor(gs.bullets.size(), SIM_GRAIN, [&](size_t begin, size_t end, size_t worker)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					if (gs.bullets.data[i].bullet.state == BulletState::moving)
+					{
+						resolveLevel(state, gs, res, gs.bullets, i, gs.scratch[worker], deltaTime);
+					}
+				}
+			});
+		// character positions are final now, look for who touches whom
+		pool.parallelFor(gs.characters.size(), SIM_GRAIN, [&](size_t begin, size_t end, size_t worker)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					findContacts(gs, gs.characters, i, gs.scratch[worker]);
+				}
+			});
+		pool.parallelFor(gs.bullets.size(), SIM_GRAIN, [&](size_t begin, size_t end, size_t worker)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					if (gs.bullets.data[i].bullet.state == BulletState::moving)
+					{
+						findContacts(gs, gs.bullets, i, gs.scratch[worker]);
+					}
+				}
+			});
+		applyContacts(state, gs, res, deltaTime);
+	}
+
+	// update animations
+	{
+		PROFILE_ZONE("animations");
+		// character animations are only for show, bullets need theirs to know when the hit animation is over
+		stepVisibleAnimations(gs, res, deltaTime);
+		stepAnimations(gs.bullets, res, deltaTime);
+		removeInactiveBullets(gs);
+	}
+}
+
+// one tick the way the game plays it: the camera follows where the player is in the simulation (not where it is drawn),
+// the level streams around the camera and then everything moves. Recordings only replay exactly because this is the same
+// in every program
+void stepGame(const SDLState& state, GameState& gs, Resources& res, LevelStreamer& level)
+{
+	gs.mapViewport.x = (gs.characters.transform[gs.player()].position.x + TILE_SIZE / 2) - gs.mapViewport.w / 2;
+	level.update(gs, res);
+	simulate(state, gs, res, TICK_TIME);
+}
+
+// FNV-1a over what the simulation carries from one tick to the next, two runs ending on the same hash played out the same
+uint64_t stateHash(const GameState& gs)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const auto add = [&hash](const auto& value)
+		{
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			for (size_t i = 0; i < sizeof(value); i++)
+			{
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+		};
+	for (const EntityStore* store : { &gs.characters, &gs.bullets })
+	{
+		add(store->size());
+		for (size_t i = 0; i < store->size(); i++)
+		{
+			add(store->type[i]);
+			add(store->transform[i].position);
+			add(store->transform[i].direction);
+			add(store->physics[i].velocity);
+			add(store->physics[i].grounded);
+			add(store->animation[i].clip);
+			add(store->animation[i].time);
+			switch (store->type[i])
+			{
+			case ObjectType::player:
+				add(store->data[i].player.state);
+				add(store->data[i].player.weaponTimer.getTime());
+				break;
+			case ObjectType::bullet:
+				add(store->data[i].bullet.state);
+				break;
+			case ObjectType::enemy:
+			case ObjectType::level:
+				break; // no state of their own, the transform and physics above are all there is
+			}
+		}
+	}
+	return hash;
+}
+
+void update(const SDLState& state, GameState& gs, Resources& res, EntityStore& store, size_t i, float deltaTime)
+{
+	ObjectData& data = store.data[i];
+	Transform& transform = store.transform[i];
+	Physics& physics = store.physics[i];
+	AnimationState& anim = store.animation[i];
+	Render& render = store.render[i];
+
+	if (physics.dynamic)
+	{
+		// applying gravity
+		physics.velocity += glm::vec2(0, 500) * deltaTime;
+	}
+
+
+	float currentDirection = 0;
+	if (store.type[i] == ObjectType::player)
+	{
+
+		if (state.keys[SDL_SCANCODE_A])
+		{
+			currentDirection += -1;
+		}
+		if (state.keys[SDL_SCANCODE_D])
+		{
+			currentDirection += 1;
+		}
+		if (currentDirection)
+		{
+			transform.direction = currentDirection;
+		}
+		Timer& weaponTimer = data.player.weaponTimer;
+		weaponTimer.step(deltaTime);
+
+		switch (data.player.state)
+		{
+		case PlayerState::idle:
+		{
+			// switch to running state
+			if (currentDirection)
+			{
+				data.player.state = PlayerState::running;
+			}
+			else
+			{
+				// decelerate
+				if (physics.velocity.x)
+				{
+					const float factor = physics.velocity.x > 0 ? -1.5f : 1.5f;
+					float amount = factor * physics.acceleration.x * deltaTime;
+					if (std::abs(physics.velocity.x) < std::abs(amount))
+					{
+						physics.velocity.x = 0;
+					}
+					else
+					{
+						physics.velocity.x += amount;
+					}
+				}
+			}
+			if (state.keys[SDL_SCANCODE_J])
+			{
+				if (weaponTimer.isTimeout())
+				{
+					weaponTimer.reset();
+					// spawn some bullets
+					// adjust bullet start position
+					const float left = 4;
+					const float right = 24;
+					const float t = (transform.direction + 1) / 2.0f; // results in a value of 0 .. 1
+					const float xOffset = left + right * t; // LERP between left and right based on direction
+					spawnBullet(gs, res,
+						glm::vec2(transform.position.x + xOffset, transform.position.y + TILE_SIZE / 2),
+						glm::vec2(physics.velocity.x + 600.0f * transform.direction, 0),
+						transform.direction);
+				}
+			}
+			render.sprite = res.SPRITE_IDLE;
+			anim.play(res.ANIM_PLAYER_IDLE);
+			break;
+		}
+		case PlayerState::running:
+		{
+			// switching to idle state
+			if (!currentDirection)
+			{
+				data.player.state = PlayerState::idle;
+				render.sprite = res.SPRITE_IDLE;
+				anim.play(res.ANIM_PLAYER_IDLE);
+			}
+			// moving in opposite direction of velocity
+			if (physics.velocity.x * transform.direction < 0 && physics.grounded)
+			{
+				render.sprite = res.SPRITE_SLIDE;
+				anim.play(res.ANIM_PLAYER_SLIDE);
+			}
+			else
+			{
+				render.sprite = res.SPRITE_RUN;
+				anim.play(res.ANIM_PLAYER_RUN);
+			}
+
+			break;
+		}
+		case PlayerState::jumping:
+		{
+			render.sprite = res.SPRITE_JUMP;
+			anim.play(res.ANIM_PLAYER_JUMP);
+			break;
+		}
+		}
+	}
+	else if (store.type[i] == ObjectType::bullet)
+	{
+		switch (data.bullet.state)
+		{
+		case BulletState::moving:
+		{
+			// flew off either end of the map
+			if (transform.position.x + store.collider[i].w < 0 || transform.position.x > gs.tiles.width())
+			{
+				data.bullet.state = BulletState::inactive;
+			}
+			break;
+		}
+		case BulletState::colliding:
+		{
+			// hit animation finished playing, slot can go back to the pool
+			if (anim.done)
+			{
+				data.bullet.state = BulletState::inactive;
+			}
+			break;
+		}
+		case BulletState::inactive:
+		{
+			// free slot in the bullet pool, nothing happens to it until it is fired again
+			break;
+		}
+		}
+		if (data.bullet.state != BulletState::moving)
+		{
+			return;
+		}
+	}
+
+	// add acceleration to velocity
+	physics.velocity += currentDirection * physics.acceleration * deltaTime;
+	if (currentDirection && std::abs(physics.velocity.x) > physics.maxSpeedX)
+	{
+		physics.velocity.x = currentDirection * physics.maxSpeedX;
+	}
+
+	// add velocity to position
+	transform.position += physics.velocity * deltaTime;
+}
+
+// moves entity i from where it started the tick towards where update() put it, stopping at the first of tiles in the way
+// (see sweep.h). Characters slide along what they hit, bullets stop at it
+static void sweepLevel(const SDLState& state, GameState& gs, Resources& res, EntityStore& store, size_t i, const AabbBatch& tiles,
+	float deltaTime)
+{
+	Transform& transform = store.transform[i];
+	Physics& physics = store.physics[i];
+	const SDL_FRect& collider = store.collider[i];
+	glm::vec2 position = transform.prevPosition;
+	glm::vec2 delta = transform.position - position;
+
+	// a character can hit a wall and then the floor in one move, after two hits there is nothing left to move along
+	bool moved = false;
+	for (int pass = 0; pass < 2 && delta != glm::vec2(0); pass++)
+	{
+		const SDL_FRect box{ position.x + collider.x, position.y + collider.y, collider.w, collider.h };
+		SweepHit first{ .time = 2 };
+		size_t firstTile = tiles.size();
+		for (size_t k = 0; k < tiles.size(); k++)
+		{
+			SweepHit hit;
+			if (sweepAabb(box, delta, tiles.rect(k), hit) && hit.time < first.time)
+			{
+				first = hit;
+				firstTile = k;
+			}
+		}
+		if (firstTile == tiles.size())
+		{
+			break;
+		}
+		moved = true;
+		position += delta * first.time;
+		if (store.type[i] == ObjectType::bullet)
+		{
+			transform.position = position;
+			const SDL_FRect rectA = store.worldCollider(i);
+			const SDL_FRect rectB = tiles.rect(firstTile);
+			SDL_FRect rectC{ 0 };
+			SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC);
+			collisionResponse(state, gs, res, rectA, rectB, rectC, store, i, ObjectType::level, deltaTime);
+			return;
+		}
+		// whatever speed went into the surface is lost, the rest of the move carries on along it
+		delta *= 1 - first.time;
+		if (first.normal.x != 0)
+		{
+			physics.velocity.x = 0;
+			delta.x = 0;
+		}
+		else
+		{
+			physics.velocity.y = 0;
+			delta.y = 0;
+		}
+	}
+	if (moved)
+	{
+		transform.position = position + delta;
+	}
+}
+
+// stops entity i at the first solid tile it ran into this tick and pushes it out of any it still overlaps, like the ones
+// it spawned in. Only entity i changes, so any number of these can run at once
+void resolveLevel(const SDLState& state, GameState& gs, Resources& res, EntityStore& store, size_t i, WorkerScratch& scratch, float deltaTime)
+{
+	// every tile the entity passed over this tick, wherever it ends up it is inside this rect
+	const Transform& transform = store.transform[i];
+	const SDL_FRect end = store.worldCollider(i);
+	const glm::vec2 delta = transform.position - transform.prevPosition;
+	const SDL_FRect swept{
+		.x = std::min(end.x, end.x - delta.x),
+		.y = std::min(end.y, end.y - delta.y),
+		.w = end.w + std::abs(delta.x),
+		.h = end.h + std::abs(delta.y)
+	};
+	AabbBatch& tiles = scratch.boxes;
+	tiles.clear();
+	gs.tiles.forEachSolid(swept, [&tiles](const SDL_FRect& tile)
+		{
+			tiles.push(tile);
+		});
+
+	sweepLevel(state, gs, res, store, i, tiles, deltaTime);
+	if (store.type[i] == ObjectType::bullet && store.data[i].bullet.state != BulletState::moving)
+	{
+		return;
+	}
+
+	// every response moves the entity, so the tiles after the one it responded to are tested again from where it ended up.
+	// That is the same as testing them one at a time in order
+	for (size_t next = 0; next < tiles.size(); next++)
+	{
+		const SDL_FRect rectA = store.worldCollider(i);
+		if (tiles.test(rectA) == 0)
+		{
+			break;
+		}
+		next = tiles.nextHit(next);
+		if (next == tiles.size())
+		{
+			break;
+		}
+		collisionResponse(state, gs, res, rectA, tiles.rect(next), tiles.intersection(next), store, i, ObjectType::level, deltaTime);
+	}
+}
+
+// loads the colliders of the characters in scratch.nearby into scratch.boxes, leaving out entity i itself
+static void gatherCharacters(GameState& gs, EntityStore& store, size_t i, WorkerScratch& scratch)
+{
+	const bool isBullet = &store == &gs.bullets;
+	scratch.boxes.clear();
+	scratch.boxIndex.clear();
+	for (uint32_t id : scratch.nearby)
+	{
+		const size_t b = gs.colliderIndex(id);
+		if (isBullet || i != b)
+		{
+			scratch.boxes.push(gs.characters.worldCollider(b));
+			scratch.boxIndex.push_back(static_cast<uint32_t>(b));
+		}
+	}
+}
+
+// true if collisionResponse() has a case for an entity of typeA touching one of typeB. findContacts() only records
+// contacts that have one, so keep this in line with the cases there
+static bool hasResponse(ObjectType typeA, ObjectType typeB)
+{
+	switch (typeA)
+	{
+	case ObjectType::player:
+	case ObjectType::enemy:
+		return typeB == ObjectType::level;
+	case ObjectType::bullet:
+		return typeB == ObjectType::level || typeB == ObjectType::enemy;
+	default:
+		return false;
+	}
+}
+
+// looks for characters touching entity i and figures out if it is standing on something. Other entities are only read,
+// what got hit goes into scratch.contacts for applyContacts() so the result doesn't depend on which thread ran first
+void findContacts(GameState& gs, EntityStore& store, size_t i, WorkerScratch& scratch)
+{
+	ObjectData& data = store.data[i];
+	Transform& transform = store.transform[i];
+	Physics& physics = store.physics[i];
+	const bool isBullet = &store == &gs.bullets;
+
+	// the characters the grid says are near us, tested all at once. Only the ones we react to make it into the contacts
+	const ObjectType type = store.type[i];
+	if (hasResponse(type, ObjectType::player) || hasResponse(type, ObjectType::enemy))
+	{
+		const SDL_FRect rectA = store.worldCollider(i);
+		gs.grid.query(rectA, scratch.nearby);
+		gatherCharacters(gs, store, i, scratch);
+		if (scratch.boxes.test(rectA) > 0)
+		{
+			for (size_t k = scratch.boxes.nextHit(0); k < scratch.boxes.size(); k = scratch.boxes.nextHit(k + 1))
+			{
+				const uint32_t b = scratch.boxIndex[k];
+				if (hasResponse(type, gs.characters.type[b]))
+				{
+					scratch.contacts.push_back(Contact{ isBullet, static_cast<uint32_t>(i), b });
+				}
+			}
+		}
+	}
+
+	// grounded sensor, a 1px strip right under our feet
+	SDL_FRect sensor{
+		.x = transform.position.x + store.collider[i].x,
+		.y = transform.position.y + store.collider[i].y + store.collider[i].h,
+		.w = store.collider[i].w,
+		.h = 1
+	};
+	AabbBatch& tiles = scratch.boxes;
+	tiles.clear();
+	gs.tiles.forEachSolid(sensor, [&tiles](const SDL_FRect& tile)
+		{
+			tiles.push(tile);
+		});
+	bool foundGround = tiles.test(sensor) > 0;
+	if (!foundGround)
+	{
+		gs.grid.query(sensor, scratch.nearby);
+		gatherCharacters(gs, store, i, scratch);
+		foundGround = scratch.boxes.test(sensor) > 0;
+	}
+
+	if (physics.grounded != foundGround)
+	{
+		// swithing grounded state
+		physics.grounded = foundGround;
+		if (physics.grounded == foundGround && store.type[i] == ObjectType::player)
+		{
+			data.player.state = PlayerState::running;
+		}
+	}
+}
+
+// responds to every contact the parallel passes found, sorted so the order is the same on any number of threads
+void applyContacts(const SDLState& state, GameState& gs, Resources& res, float deltaTime)
+{
+	gs.contacts.clear();
+	for (WorkerScratch& scratch : gs.scratch)
+	{
+		gs.contacts.insert(gs.contacts.end(), scratch.contacts.begin(), scratch.contacts.end());
+		scratch.contacts.clear();
+	}
+	std::sort(gs.contacts.begin(), gs.contacts.end());
+	for (const Contact& contact : gs.contacts)
+	{
+		EntityStore& store = contact.bullet ? gs.bullets : gs.characters;
+		checkCollision(state, gs, res, store, contact.a, gs.characters.worldCollider(contact.b), gs.characters.type[contact.b], deltaTime);
+	}
+}
+
+void collisionResponse(const SDLState& state, GameState& gs, Resources& res, const SDL_FRect& rectA, const SDL_FRect& rectB,
+	const SDL_FRect& rectC, EntityStore& storeA, size_t a, ObjectType typeB, float deltaTime)
+{
+	ObjectData& dataA = storeA.data[a];
+	Transform& transformA = storeA.transform[a];
+	Physics& physicsA = storeA.physics[a];
+	AnimationState& animA = storeA.animation[a];
+
+	// object to check
+	if (storeA.type[a] == ObjectType::player || storeA.type[a] == ObjectType::enemy)
+	{
+		// object it is colliding with, a new case has to be added to hasResponse() as well
+		switch (typeB)
+		{
+		case ObjectType::level:
+		{
+			// if a character collides with level object the height of rectC would be much greater than the width
+			// we resolve the collision by increasing the height of player by the height of rectC and vice versa for horizontally colliding 
+			if (rectC.w < rectC.h)
+			{
+				// horizontal collision
+
+				if (physicsA.velocity.x > 0)
+				{
+					transformA.position.x -= rectC.w; // going right
+				}
+				else if (physicsA.velocity.x < 0)
+				{
+					transformA.position.x += rectC.w; // going left
+				}
+				physicsA.velocity.x = 0;
+			}
+			else
+			{
+				// vertical collision
+
+				if (physicsA.velocity.y > 0)
+				{
+					transformA.position.y -= rectC.h; // going down
+				}
+				else if (physicsA.velocity.y < 0)
+				{
+					transformA.position.y += rectC.h; // going up
+				}
+				physicsA.velocity.y = 0;
+			}
+			break;
+		}
+
+		}
+	}
+	else if (storeA.type[a] == ObjectType::bullet)
+	{
+		// object it is hitting, a new case has to be added to hasResponse() as well
+		switch (typeB)
+		{
+		case ObjectType::level:
+		case ObjectType::enemy:
+		{
+			// bullet hit a tile or an enemy, stop it and play the hit animation before it gets retired
+			if (dataA.bullet.state == BulletState::moving)
+			{
+				dataA.bullet.state = BulletState::colliding;
+				physicsA.velocity = glm::vec2(0);
+				storeA.render[a].sprite = res.SPRITE_BULLET_HIT;
+				animA.play(res.ANIM_BULLET_HIT);
+			}
+			break;
+		}
+		}
+	}
+}
+
+//rect A, B, C are representing hitboxes to see if two gameObjects are intersecting
+//rect c will show how far two objects are overlapping
+void checkCollision(const SDLState& state, GameState& gs, Resources& res, EntityStore& storeA, size_t a, const SDL_FRect& rectB, ObjectType typeB, float deltaTime)
+{
+	SDL_FRect rectA = storeA.worldCollider(a);
+	SDL_FRect rectC{ 0 };
+
+	if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC))
+	{
+		// found the intersection
+		collisionResponse(state, gs, res, rectA, rectB, rectC, storeA, a, typeB, deltaTime);
+	}
+}
+
+void setupTileTypes(GameState& gs, const Resources& res)
+{
+	gs.tiles.setType(1, TileType{ res.texGround, true });
+	gs.tiles.setType(2, TileType{ res.texPanel, true });
+	gs.tiles.setType(5, TileType{ res.texGrass, false });
+	gs.tiles.setType(6, TileType{ res.texBrick, false });
+}
+
+// creates a character and registers it with the broadphase, spawnPlayer / spawnEnemy fill in the type specific parts
+Entity spawnCharacter(GameState& gs, const Resources& res, ObjectType type, const glm::vec2& position)
+{
+	EntityStore& characters = gs.characters;
+	Entity e = characters.create();
+	const size_t i = characters.indexOf(e);
+	characters.type[i] = type;
+	characters.transform[i] = Transform();
+	characters.transform[i].position = position;
+	characters.transform[i].prevPosition = position;
+	characters.render[i].sprite = res.SPRITE_IDLE;
+	characters.animation[i] = AnimationState(res.ANIM_PLAYER_IDLE);
+	characters.physics[i] = Physics();
+	characters.physics[i].acceleration = glm::vec2(300, 0);
+	characters.physics[i].maxSpeedX = 100;
+	characters.physics[i].dynamic = true;
+	characters.collider[i] = {
+		.x = 11,
+		.y = 6,
+		.w = 10,
+		.h = 26
+	};
+	gs.grid.insert(GameState::colliderId(e), characters.worldCollider(i));
+	return e;
+}
+
+Entity spawnPlayer(GameState& gs, const Resources& res, const glm::vec2& position)
+{
+	gs.playerEntity = spawnCharacter(gs, res, ObjectType::player, position);
+	gs.characters.data[gs.player()].player = PlayerData();
+	return gs.playerEntity;
+}
+
+Entity spawnEnemy(GameState& gs, const Resources& res, const glm::vec2& position)
+{
+	Entity e = spawnCharacter(gs, res, ObjectType::enemy, position);
+	gs.characters.data[gs.characters.indexOf(e)].enemy = EnemyData();
+	return e;
+}
+
+// takes the character out of the broadphase and the store, the last character moves into index i
+void destroyCharacter(GameState& gs, size_t i)
+{
+	gs.grid.remove(GameState::colliderId(gs.characters.entityAt(i)));
+	gs.characters.destroy(i);
+}
+
+// returns an invalid handle if every pool slot is taken, the shot is simply skipped then
+Entity spawnBullet(GameState& gs, const Resources& res, const glm::vec2& position, const glm::vec2& velocity, float direction)
+{
+	EntityStore& bullets = gs.bullets;
+	Entity bullet = bullets.create();
+	if (!bullets.isValid(bullet))
+	{
+		return bullet;
+	}
+	const size_t b = bullets.indexOf(bullet);
+	bullets.type[b] = ObjectType::bullet;
+	bullets.data[b].bullet = BulletData();
+	bullets.transform[b].position = position;
+	bullets.transform[b].prevPosition = position; // nothing to interpolate from yet
+	bullets.transform[b].direction = direction;
+	bullets.render[b].sprite = res.SPRITE_BULLET;
+	bullets.animation[b] = AnimationState(res.ANIM_BULLET_MOVING);
+	bullets.collider[b] = SDL_FRect{
+		.x = 0,
+		.y = 0,
+		.w = res.texBullet.height(),
+		.h = res.texBullet.height(),
+	};
+	bullets.physics[b] = Physics();
+	bullets.physics[b].velocity = velocity;
+	return bullet;
+}
+
+void handleKeyInput(const SDLState& state, GameState& gs, EntityStore& store, size_t i,
+	SDL_Scancode key, bool keyDown)
+{
+
+	const float JUMP_FORCE = -200.0f;
+	if (store.type[i] == ObjectType::player)
+	{
+		switch (store.data[i].player.state)
+		{
+		case PlayerState::idle:
+		{
+			if (key == SDL_SCANCODE_K && keyDown)
+			{
+				store.data[i].player.state = PlayerState::jumping;
+				store.physics[i].velocity.y += JUMP_FORCE;
+
+			}
+			break;
+		}
+		case PlayerState::running:
+		{
+			if (key == SDL_SCANCODE_K && keyDown)
+			{
+				store.data[i].player.state = PlayerState::jumping;
+				store.physics[i].velocity.y += JUMP_FORCE;
+			}
+			break;
+		}
+		}
+	}
+}
+
+void savePreviousPositions(EntityStore& store)
+{
+	for (size_t i = 0; i < store.size(); i++)
+	{
+		store.transform[i].prevPosition = store.transform[i].position;
+	}
+}
+
+// steps the current animation of every entity in the store, only the animation array and the clip lengths are touched
+void stepAnimations(EntityStore& store, const Resources& res, float deltaTime)
+{
+	for (size_t i = 0; i < store.size(); i++)
+	{
+		AnimationState& anim = store.animation[i];
+		if (anim.clip != -1)
+		{
+			anim.step(res.clips[anim.clip].getLength(), deltaTime);
+		}
+	}
+}
+
+// characters off screen keep their current frame until they are back in view, the grid tells us who is near the camera
+void stepVisibleAnimations(GameState& gs, const Resources& res, float deltaTime)
+{
+	gs.grid.query(gs.visibleArea(), gs.nearby);
+	for (uint32_t id : gs.nearby)
+	{
+		AnimationState& anim = gs.characters.animation[gs.colliderIndex(id)];
+		if (anim.clip != -1)
+		{
+			anim.step(res.clips[anim.clip].getLength(), deltaTime);
+		}
+	}
+}
+
+// gives the pool slots of bullets marked inactive this frame back to the store
+void removeInactiveBullets(GameState& gs)
+{
+	size_t i = 0;
+	while (i < gs.bullets.size())
+	{
+		if (gs.bullets.data[i].bullet.state == BulletState::inactive)
+		{
+			gs.bullets.destroy(i); // the last bullet was moved into slot i, so look at i again
+		}
+		else
+		{
+			i++;
+		}
+	}
+}
+// reads the size straight out of the PNG header (IHDR chunk) without decoding anything,
+// without a renderer there's nowhere to put pixels anyway and the simulation only ever needs sizes
+bool readImageSize(const std::string& filepath, int& width, int& height)
+{
+	Uint8 header[24];
+	SDL_IOStream* io = SDL_IOFromFile(filepath.c_str(), "rb");
+	bool success = io && SDL_ReadIO(io, header, sizeof(header)) == sizeof(header);
+	if (success)
+	{
+		// width and height are big endian 32 bit ints right after the signature and the IHDR chunk header
+		width = header[16] << 24 | header[17] << 16 | header[18] << 8 | header[19];
+		height = header[20] << 24 | header[21] << 16 | header[22] << 8 | header[23];
+	}
+	else
+	{
+		SDL_Log("Could not read image size from %s", filepath.c_str());
+	}
+	if (io)
+	{
+		SDL_CloseIO(io);
+	}
+	return success;
+}
+
+// copies src into dst at x, y and repeats its outermost pixels one more pixel outwards, so sampling right at the
+// edge of a region (scaled or at a fractional position) picks up the region's own colour instead of a neighbour's
+static void blitWithEdges(SDL_Surface* src, SDL_Surface* dst, int x, int y)
+{
+	SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+	const int w = src->w, h = src->h;
+	const SDL_Rect copies[][2] = {
+		{ { 0, 0, w, h }, { x, y, w, h } },
+		{ { 0, 0, 1, h }, { x - 1, y, 1, h } },
+		{ { w - 1, 0, 1, h }, { x + w, y, 1, h } },
+		{ { 0, 0, w, 1 }, { x, y - 1, w, 1 } },
+		{ { 0, h - 1, w, 1 }, { x, y + h, w, 1 } },
+	};
+	for (const auto& copy : copies)
+	{
+		SDL_BlitSurface(src, &copy[0], dst, &copy[1]);
+	}
+}
+
+SDL_Surface* AssetLoader::decode(Image& image)
+{
+	const std::string& path = image.path;
+	const int padding = image.padding;
+	image.fromCache = false;
+	SDL_Surface* cached = readTextureCache(path, padding, image.mapping);
+	if (cached)
+	{
+		image.fromCache = true;
+		return cached;
+	}
+
+	SDL_Surface* loaded = IMG_Load(path.c_str());
+	if (!loaded)
+	{
+		SDL_Log("Could not load %s: %s", path.c_str(), SDL_GetError());
+		return nullptr;
+	}
+	// one pixel format for every image so uploading into an atlas page is a plain copy
+	SDL_Surface* converted = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+	SDL_DestroySurface(loaded);
+	if (!converted || padding == 0)
+	{
+		return converted;
+	}
+	SDL_Surface* padded = SDL_CreateSurface(converted->w + 2 * padding, converted->h + 2 * padding, SDL_PIXELFORMAT_RGBA32);
+	if (padded)
+	{
+		blitWithEdges(converted, padded, padding, padding);
+		// next start can skip all of the above
+		if (!writeTextureCache(path, padding, padded))
+		{
+			SDL_Log("Could not write %s to the texture cache", path.c_str());
+		}
+	}
+	SDL_DestroySurface(converted);
+	return padded;
+}
+
+/*
+NOTE: Every texture switch between draws ends a batch and costs the GPU a state change. So instead of one texture per
+PNG, all images are packed onto as few atlas pages as possible and every page is a single texture. Sprites and tiles
+then only hold a region of a page, and a whole frame can draw from one texture.
+Packing only needs the image sizes, which the PNG headers have, so the pages and regions are ready before anything is
+decoded. The pixels get uploaded into their spot one image at a time by updateLoad() as the loader finishes them.
+*/
+void Resources::buildAtlas(SDL_Renderer* renderer)
+{
+	std::vector<SDL_Point> sizes(imagePaths.size(), SDL_Point{ 0, 0 });
+	for (size_t i = 0; i < imagePaths.size(); i++)
+	{
+		readImageSize(imagePaths[i], sizes[i].x, sizes[i].y);
+	}
+
+	int pageSize = ATLAS_PAGE_SIZE;
+	if (renderer)
+	{
+		const Sint64 maxSize = SDL_GetNumberProperty(SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_MAX_TEXTURE_SIZE_NUMBER, ATLAS_PAGE_SIZE);
+		pageSize = static_cast<int>(std::min<Sint64>(pageSize, maxSize));
+	}
+	std::vector<SDL_Point> pageSizes;
+	const std::vector<AtlasPlacement> placements = packAtlas(sizes, pageSize, ATLAS_PADDING, pageSizes);
+
+	const size_t firstPage = textures.size();
+	for (size_t p = 0; p < pageSizes.size(); p++)
+	{
+		SDL_Texture* page = nullptr;
+		if (renderer)
+		{
+			page = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, pageSizes[p].x, pageSizes[p].y);
+			SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+			SDL_SetTextureScaleMode(page, SDL_SCALEMODE_NEAREST); //changes from linear scaling to nearest neighbour scaling on sprite for better quality
+		}
+		else
+		{
+			// without a renderer only the size of a page is ever looked at
+			stubTextures = true;
+			page = new SDL_Texture{};
+			page->refcount = 1;
+			page->w = pageSizes[p].x;
+			page->h = pageSizes[p].y;
+		}
+		textures.push_back(page);
+	}
+
+	regions.resize(imagePaths.size());
+	for (size_t i = 0; i < imagePaths.size(); i++)
+	{
+		regions[i].texture = textures[firstPage + placements[i].page];
+		regions[i].area = SDL_FRect{
+			.x = static_cast<float>(placements[i].x),
+			.y = static_cast<float>(placements[i].y),
+			.w = static_cast<float>(sizes[i].x),
+			.h = static_cast<float>(sizes[i].y)
+		};
+	}
+	SDL_Log("Packed %zu images into %zu atlas page(s)", imagePaths.size(), pageSizes.size());
+}
+
+// the decoded surface carries its padding, so it covers a bit more than the region itself
+static SDL_Rect paddedRect(const AtlasRegion& region, int padding)
+{
+	return SDL_Rect{
+		.x = static_cast<int>(region.area.x) - padding,
+		.y = static_cast<int>(region.area.y) - padding,
+		.w = static_cast<int>(region.area.w) + 2 * padding,
+		.h = static_cast<int>(region.area.h) + 2 * padding
+	};
+}
+
+bool Resources::updateLoad(SDL_Renderer* renderer)
+{
+	if (!renderer || loader.isDone())
+	{
+		return true;
+	}
+	const uint64_t start = SDL_GetPerformanceCounter();
+	loader.takeFinished(arrived);
+	for (size_t i : arrived)
+	{
+		AssetLoader::Image& image = loader.image(i);
+		const AtlasRegion& region = regions[i];
+		const SDL_Rect rect = paddedRect(region, ATLAS_PADDING);
+		if (image.surface && image.surface->w == rect.w && image.surface->h == rect.h)
+		{
+			SDL_UpdateTexture(region.texture, &rect, image.surface->pixels, image.surface->pitch);
+		}
+		else
+		{
+			// texture memory starts out undefined, at least make the region transparent
+			SDL_Log("%s did not load, its atlas region stays empty", image.path.c_str());
+			std::vector<Uint32> transparent(static_cast<size_t>(rect.w) * rect.h, 0);
+			SDL_UpdateTexture(region.texture, &rect, transparent.data(), rect.w * 4);
+		}
+		SDL_DestroySurface(image.surface);
+		image.surface = nullptr;
+		image.mapping.reset();
+		decodeSeconds += image.decodeSeconds;
+	}
+	uploadSeconds += (SDL_GetPerformanceCounter() - start) / static_cast<double>(SDL_GetPerformanceFrequency());
+
+	if (!loader.isDone())
+	{
+		return false;
+	}
+	const size_t threads = loader.threadCount();
+	loader.finish();
+	SDL_Log("Loaded %zu images (%zu from the texture cache) in %.1f ms on %zu threads, doing them one after another would take %.1f ms (uploading %.1f ms)",
+		loader.imageCount(), loader.cachedCount(), loader.secondsSinceStart() * 1000.0, threads, decodeSeconds * 1000.0, uploadSeconds * 1000.0);
+	return true;
+}
+
+bool Resources::reloadImage(const std::string& path)
+{
+	const auto image = std::find(imagePaths.begin(), imagePaths.end(), path);
+	if (image == imagePaths.end())
+	{
+		return false;
+	}
+	const size_t i = image - imagePaths.begin();
+	if (std::find(reloadQueue.begin(), reloadQueue.end(), i) == reloadQueue.end())
+	{
+		reloadQueue.push_back(i);
+	}
+	return true;
+}
+
+bool Resources::updateReload(SDL_Renderer* renderer)
+{
+	if (!renderer)
+	{
+		return false;
+	}
+	bool changed = false;
+	if (!reloading.empty())
+	{
+		loader.takeFinished(arrived);
+		for (size_t i : arrived)
+		{
+			AssetLoader::Image& image = loader.image(i);
+			const SDL_Rect rect = paddedRect(regions[reloading[i]], ATLAS_PADDING);
+			if (image.surface && image.surface->w == rect.w && image.surface->h == rect.h)
+			{
+				SDL_UpdateTexture(regions[reloading[i]].texture, &rect, image.surface->pixels, image.surface->pitch);
+				SDL_Log("Reloaded %s in %.1f ms", image.path.c_str(), image.decodeSeconds * 1000.0);
+				changed = true;
+			}
+			else if (image.surface)
+			{
+				SDL_Log("%s changed its size, restart to see the new version", image.path.c_str());
+			}
+			else
+			{
+				SDL_Log("%s did not load, keeping the old version", image.path.c_str());
+			}
+			SDL_DestroySurface(image.surface);
+			image.surface = nullptr;
+			image.mapping.reset();
+		}
+		if (!loader.isDone())
+		{
+			return changed;
+		}
+		loader.finish();
+		reloading.clear();
+	}
+
+	// whatever changed while the last batch was decoding goes out as the next one
+	if (!reloadQueue.empty())
+	{
+		std::vector<std::string> paths;
+		for (size_t i : reloadQueue)
+		{
+			paths.push_back(imagePaths[i]);
+		}
+		reloading.swap(reloadQueue);
+		reloadQueue.clear();
+		loader.start(paths, ATLAS_PADDING);
+	}
+	return changed;
+}
@@ -0,0 +1,285 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "aabbBatch.h"
+#include "assetLoader.h"
+#include "atlas.h"
+#include "gameObject.h"
+#include "entityStore.h"
+#include "jobSystem.h"
+#include "levelStreamer.h"
+#include "spatialGrid.h"
+#include "sweep.h"
+#include "tileMap.h"
+#include "profiler.h"
+
+//hold important SDL objects in state to make cleanup and init more efficient by just passing through single SDL state object instead of passing SDL objects to SDL state
+struct SDLState
+{
+	SDL_Window* window;
+	SDL_Renderer* renderer;
+	int width, height, logicalWidth, logicalHeight;
+	const bool* keys;
+
+	SDLState() : keys(SDL_GetKeyboardState(nullptr))
+	{
+	}
+};
+
+
+const int MAP_ROWS = 5; // height of the levels headless makes up, real levels bring their own size
+const int TILE_SIZE = 32;
+const size_t MAX_BULLETS = 256;
+const float TICK_RATE = 120.0f; // simulation steps per second, independent of the display refresh rate
+const float TICK_TIME = 1.0f / TICK_RATE;
+const double MAX_FRAME_TIME = 0.25; // after a hitch we only catch up this much simulated time and drop the rest
+const size_t SIM_GRAIN = 256; // entities per job when the simulation runs in parallel, fewer than this stay on one thread
+
+// two entities found touching by a parallel collision pass, applied one after another by applyContacts()
+struct Contact
+{
+	uint32_t bullet; // 1 if a is a bullet, 0 if it is a character. Sorting puts characters first like the serial loops did
+	uint32_t a; // index in its store
+	uint32_t b; // index in characters
+	bool operator<(const Contact& other) const
+	{
+		return bullet != other.bullet ? bullet < other.bullet : a != other.a ? a < other.a : b < other.b;
+	}
+};
+
+// per thread memory for the parallel passes, so jobs never share a scratch list
+struct WorkerScratch
+{
+	std::vector<uint32_t> nearby;
+	std::vector<Contact> contacts;
+	AabbBatch boxes; // candidates of the box test running right now, tiles or characters
+	std::vector<uint32_t> boxIndex; // character index of each of boxes' candidates when they are characters
+};
+
+struct GameState
+{
+	TileMap tiles;
+	EntityStore characters;
+	EntityStore bullets; // fixed capacity, a shot is skipped when every slot is taken
+
+	Entity playerEntity;
+	SDL_FRect mapViewport;
+	float bg2Scroll, bg3Scroll, bg4Scroll;
+
+	// broadphase for characters, level tiles are looked up straight from the tile map instead
+	SpatialGrid grid;
+	std::vector<uint32_t> nearby; // scratch list reused by every grid query on the main thread
+	std::vector<WorkerScratch> scratch; // one per job system thread
+	std::vector<Contact> contacts; // everything the threads found, in the order it gets applied
+
+	GameState(const SDLState& state, size_t maxBullets = MAX_BULLETS) : bullets(maxBullets), grid(TILE_SIZE)
+	{
+		playerEntity = Entity{ UINT32_MAX, 0 };
+		mapViewport = SDL_FRect{
+			.x = 0,
+			.y = 0,
+			.w = static_cast<float>(state.logicalWidth),
+			.h = static_cast<float>(state.logicalHeight)
+		};
+		bg2Scroll = bg3Scroll = bg4Scroll = 0;
+	}
+	size_t player() const { return characters.indexOf(playerEntity); } // index of the player inside characters
+
+	// the camera grown by a tile on every side, nothing outside of it can end up on screen this frame
+	SDL_FRect visibleArea() const
+	{
+		return SDL_FRect{
+			.x = mapViewport.x - TILE_SIZE,
+			.y = mapViewport.y - TILE_SIZE,
+			.w = mapViewport.w + 2 * TILE_SIZE,
+			.h = mapViewport.h + 2 * TILE_SIZE
+		};
+	}
+
+	// the map and the sky above it, characters aren't expected anywhere else so this is what the grid covers
+	SDL_FRect levelBounds() const
+	{
+		const float top = std::min(0.0f, tiles.getOriginY());
+		return SDL_FRect{
+			.x = 0,
+			.y = top,
+			.w = tiles.width(),
+			.h = tiles.getOriginY() + tiles.getRows() * tiles.getTileSize() - top
+		};
+	}
+
+	// grid ids are entity slots, they stay the same while the entity moves around in the arrays
+	static uint32_t colliderId(Entity e) { return e.index; }
+	size_t colliderIndex(uint32_t id) const { return characters.indexOfSlot(id); }
+};
+bool readImageSize(const std::string& filepath, int& width, int& height);
+
+struct Resources
+{
+	// every animation anything can play, entities refer to them by these indices
+	const int ANIM_PLAYER_IDLE = 0;
+	const int ANIM_PLAYER_RUN = 1;
+	const int ANIM_PLAYER_JUMP = 2;
+	const int ANIM_PLAYER_SLIDE = 3;
+	const int ANIM_BULLET_MOVING = 4;
+	const int ANIM_BULLET_HIT = 5;
+	std::vector<AnimationClip> clips;
+
+	// every sprite sheet an entity can show, Render refers to them by these indices so entities hold no texture pointers
+	const int SPRITE_IDLE = 0;
+	const int SPRITE_RUN = 1;
+	const int SPRITE_JUMP = 2;
+	const int SPRITE_SLIDE = 3;
+	const int SPRITE_BULLET = 4;
+	const int SPRITE_BULLET_HIT = 5;
+	std::vector<AtlasRegion> sprites;
+
+	static const int ATLAS_PAGE_SIZE = 2048; // most GPUs take at least this, it gets lowered if the renderer can't
+	static const int ATLAS_PADDING = 1; // edge pixels get repeated into the padding so nothing bleeds in from the neighbours
+
+	std::vector<SDL_Texture*> textures; // atlas pages, everything below points into one of them
+	AtlasRegion texIdle, texRun, texJump, texSlide, texBrick, texGrass, texGround, texPanel,
+		texBg1, texBg2, texBg3, texBg4, texBg5, texBg6, texBg7, texBg8, texBg9, texBullet, texBulletHit;
+	bool stubTextures = false; // true when loaded without a renderer (headless runs)
+
+	std::vector<std::string> imagePaths; // images waiting for buildAtlas()
+	std::vector<AtlasRegion> regions; // where each image of imagePaths ended up
+	size_t addImage(const std::string& filepath)
+	{
+		imagePaths.push_back(filepath);
+		return imagePaths.size() - 1;
+	}
+	void buildAtlas(SDL_Renderer* renderer);
+
+	AssetLoader loader; // decodes the images on worker threads
+	std::vector<size_t> arrived; // scratch list for images the loader finished
+	double decodeSeconds = 0, uploadSeconds = 0; // for the load report
+
+	// uploads whatever finished decoding since the last call, returns true once every image is on the GPU
+	bool updateLoad(SDL_Renderer* renderer);
+	// hot reload, only once updateLoad() returned true: queues the image at path to be decoded again, false if it isn't
+	// one of imagePaths
+	bool reloadImage(const std::string& path);
+	// uploads reloaded images over their old pixels and starts decoding the queued ones, returns true if any pixels
+	// changed. Regions stay where they are, so nothing that points at them has to know. An image that changed its size
+	// would need the atlas packed again and is left alone until the next start
+	bool updateReload(SDL_Renderer* renderer);
+	std::vector<size_t> reloadQueue; // images waiting for the loader to be free
+	std::vector<size_t> reloading; // the image of imagePaths for each image the loader is decoding again
+
+	// 0 .. 1, for a loading bar
+	float loadProgress() const
+	{
+		return loader.imageCount() ? static_cast<float>(loader.takenCount()) / loader.imageCount() : 1.0f;
+	}
+	// blocks until everything is loaded, for when there is nothing to show in the meantime
+	void load(SDLState& state)
+	{
+		beginLoad(state);
+		while (!updateLoad(state.renderer))
+		{
+			SDL_Delay(1);
+		}
+	}
+
+	// sets everything up and starts decoding in the background, regions can be used right away but only
+	// show the right pixels once updateLoad() returned true
+	void beginLoad(SDLState& state)
+	{
+		// all images get packed into as few textures as possible, regions are only known once everything is packed
+		const size_t hood = addImage("data/spriteHood.png");
+		const size_t brick = addImage("data/PixelTexturePack/Textures/Bricks/REDBRICKS.png");
+		const size_t grass = addImage("data/PixelTexturePack/grass.png");
+		const size_t ground = addImage("data/PixelTexturePack/Textures/Rocks/FLATSTONES.png");
+		const size_t panel = addImage("data/PixelTexturePack/Textures/Tech/BIGSQUARES.png");
+		const size_t bullet = addImage("data/bulletDemo.png");
+		const size_t bulletHit = addImage("data/bullet_hitDemo.png");
+		const size_t bg1 = addImage("data/nature_4/1.png");
+		const size_t bg2 = addImage("data/nature_4/2.png");
+		const size_t bg3 = addImage("data/nature_4/3.png");
+		const size_t bg4 = addImage("data/nature_4/4.png");
+		buildAtlas(state.renderer);
+		decodeSeconds = uploadSeconds = 0;
+		if (state.renderer)
+		{
+			loader.start(imagePaths, ATLAS_PADDING);
+		}
+
+		texIdle = regions[hood];
+		texRun = texIdle; //anim in the same file
+		texJump = texIdle;
+		texSlide = texIdle;
+		texBrick = regions[brick];
+		texGrass = regions[grass];
+		texGround = regions[ground];
+		texPanel = regions[panel];
+		texBullet = regions[bullet];
+		texBulletHit = regions[bulletHit];
+		texBg1 = regions[bg1];
+		texBg2 = regions[bg2];
+		texBg3 = regions[bg3];
+		texBg4 = regions[bg4];
+
+		// same order as the SPRITE_ constants
+		sprites = { texIdle, texRun, texJump, texSlide, texBullet, texBulletHit };
+
+		// character frames are TILE_SIZE squares, the bullet sheets are one row of squares as high as the image.
+		// Same order as the ANIM_ constants
+		const float bulletSize = texBullet.height();
+		clips = {
+			AnimationClip(2, 1.6f, 0, 1, TILE_SIZE, TILE_SIZE),
+			AnimationClip(8, 1.6f, 0, 3, TILE_SIZE, TILE_SIZE),
+			AnimationClip(8, 1.6f, 0, 5, TILE_SIZE, TILE_SIZE),
+			AnimationClip(2, 1.0f, 0, 1, TILE_SIZE, TILE_SIZE),
+			AnimationClip(4, 0.05f, 0, 0, bulletSize, bulletSize),
+			AnimationClip(4, 0.15f, 0, 0, bulletSize, bulletSize),
+		};
+	}
+
+	void unload()
+	{
+		loader.cancel();
+		for (SDL_Texture* tex : textures)
+		{
+			if (stubTextures)
+			{
+				delete tex;
+			}
+			else
+			{
+				SDL_DestroyTexture(tex);
+			}
+
+		}
+		textures.clear();
+		imagePaths.clear();
+		regions.clear();
+		reloadQueue.clear();
+		reloading.clear();
+	}
+};
+
+void simulate(const SDLState& state, GameState& gs, Resources& res, float deltaTime);
+void stepGame(const SDLState& state, GameState& gs, Resources& res, LevelStreamer& level);
+uint64_t stateHash(const GameState& gs);
+void resolveLevel(const SDLState& state, GameState& gs, Resources& res, EntityStore& store, size_t i, WorkerScratch& scratch, float deltaTime);
+void findContacts(GameState& gs, EntityStore& store, size_t i, WorkerScratch& scratch);
+void applyContacts(const SDLState& state, GameState& gs, Resources& res, float deltaTime);
+void update(const SDLState& state, GameState& gs, Resources& res, EntityStore& store, size_t i, float deltaTime);
+void stepAnimations(EntityStore& store, const Resources& res, float deltaTime);
+void stepVisibleAnimations(GameState& gs, const Resources& res, float deltaTime);
+void savePreviousPositions(EntityStore& store);
+void removeInactiveBullets(GameState& gs);
+const char* const DEFAULT_LEVEL = "data/levels/level1.lvl"; // written by sdl3-level-convert, opened with LevelStreamer::open
+void setupTileTypes(GameState& gs, const Resources& res);
+Entity spawnPlayer(GameState& gs, const Resources& res, const glm::vec2& position);
+Entity spawnEnemy(GameState& gs, const Resources& res, const glm::vec2& position);
+void destroyCharacter(GameState& gs, size_t i);
+Entity spawnBullet(GameState& gs, const Resources& res, const glm::vec2& position, const glm::vec2& velocity, float direction);
+void collisionResponse(const SDLState& state, GameState& gs, Resources& res, const SDL_FRect& rectA, const SDL_FRect& rectB,
+	const SDL_FRect& rectC, EntityStore& storeA, size_t a, ObjectType typeB, float deltaTime);
+void checkCollision(const SDLState& state, GameState& gs, Resources& res, EntityStore& storeA, size_t a, const SDL_FRect& rectB, ObjectType typeB, float deltaTime);
+void handleKeyInput(const SDLState& state, GameState& gs, EntityStore& store, size_t i, SDL_Scancode key, bool keyDown);
@@ -1,8 +1,10 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <vector>
-#include <sdl3/SDL.h>
+#include <SDL3/SDL.h>
 #include "animation.h"
+#include "atlas.h"
+#include "timer.h"
 
 /*
 NOTE: Code can become very complicated and unmanageable the more features you begin to add like jumping, shooting, crouching.
@@ -47,6 +49,10 @@ union ObjectData
 	LevelData level;
 	EnemyData enemy;
 	BulletData bullet;
+
+	ObjectData() : level()
+	{
+	}
 };
 
 enum class ObjectType
@@ -57,32 +63,78 @@ enum class ObjectType
 	bullet // Added bullet type to fix the error
 };
 
+/*
+NOTE: A game object used to be one big struct holding everything about it. Most loops only read a couple of floats from it
+but still had to drag the whole struct (animation vector, texture pointer, etc) through the cache.
+Each object is now split into components that live in their own arrays inside an EntityStore, so a loop only
+touches the arrays it actually needs.
+*/
 
+// stable reference to an entity, stays valid while the entity moves around inside its store's arrays
+struct Entity
+{
+	uint32_t index;
+	uint32_t generation;
+};
 
-struct GameObject
+struct Transform
 {
-	ObjectType type;
-	ObjectData data;
-	glm::vec2 position, velocity, acceleration;
+	glm::vec2 position;
+	glm::vec2 prevPosition; // position at the start of the last simulation tick, used to interpolate when drawing
 	float direction;
+
+	Transform() : position(0), prevPosition(0), direction(1)
+	{
+	}
+};
+
+struct Physics
+{
+	glm::vec2 velocity, acceleration;
 	float maxSpeedX;
-	std::vector<Animation> animations;
-	int currentAnimation;
-	SDL_Texture* texture;
 	bool dynamic;
 	bool grounded;
-	SDL_FRect collider;
 
+	Physics() : velocity(0), acceleration(0), maxSpeedX(0), dynamic(false), grounded(false)
+	{
+	}
+};
+
+// playback of one of Resources::clips, the clip itself is shared
+struct AnimationState
+{
+	int clip; // index into Resources::clips, -1 shows the first frame of the sprite
+	float time; // seconds into the clip, wraps around at its length
+	bool done; // played through at least once
+
+	AnimationState(int clip = -1) : clip(clip), time(0), done(false)
+	{
+	}
 
-	GameObject() : data{ .level = LevelData() }, collider{ 0 }
+	// switches to clip and starts it from the beginning, keeps playing if it already is the current one
+	void play(int newClip)
+	{
+		if (clip != newClip)
+		{
+			*this = AnimationState(newClip);
+		}
+	}
+	void step(float length, float deltaTime)
 	{
-		type = ObjectType::level;
-		direction = 1;
-		maxSpeedX = 0;
-		position = velocity = acceleration = glm::vec2(0);
-		currentAnimation = -1;
-		texture = nullptr;
-		dynamic = false;
-		grounded = false;
+		time += deltaTime;
+		if (time >= length)
+		{
+			time -= length; // not setting to zero since internal time tracking would not match real time
+			done = true;
+		}
 	}
-};
\ No newline at end of file
+};
+
+struct Render
+{
+	int sprite; // index into Resources::sprites, the sheet animation frames are picked from
+
+	Render(int sprite = 0) : sprite(sprite)
+	{
+	}
+};
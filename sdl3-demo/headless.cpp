@@ -0,0 +1,311 @@
+// headless.cpp : Runs the game simulation without a window, renderer or GPU and reports how fast it goes.
+//
+// usage: sdl3-headless [--tiles N] [--entities N] [--bullets N] [--ticks N] [--seed N] [--trace file.json] [--level file.lvl] [--threads N]
+//                      [--record file.inp] [--replay file.inp]
+// run it from the folder that contains data/, the textures are only opened to read their size
+
+#include "allocationCounter.h"
+#include "frameArena.h"
+#include "game.h"
+#include "inputRecording.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+struct BenchOptions
+{
+	int tiles = 1000; // level length in columns
+	int entities = 100; // enemies spread over the level, on top of the player
+	int bullets = 100; // bullets kept alive at all times
+	int ticks = 10000;
+	unsigned seed = 1;
+	int threads = 0; // job system threads including the main one, 0 means one per core
+	const char* trace = nullptr; // where to write the profiler zones of the last ticks, if anywhere
+	const char* level = nullptr; // play this level instead of making one up, --tiles and --entities are ignored then
+	const char* record = nullptr; // write the scripted input to this file, needs --level. Bullets only come from the player then
+	const char* replay = nullptr; // play a recording as fast as possible instead, everything but --threads and --trace is ignored
+};
+
+static bool parseArgs(int argc, char* argv[], BenchOptions& opt)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			return false;
+		}
+		if (std::strcmp(argv[i], "--trace") == 0)
+		{
+			opt.trace = argv[++i];
+			continue;
+		}
+		if (std::strcmp(argv[i], "--level") == 0)
+		{
+			opt.level = argv[++i];
+			continue;
+		}
+		if (std::strcmp(argv[i], "--record") == 0)
+		{
+			opt.record = argv[++i];
+			continue;
+		}
+		if (std::strcmp(argv[i], "--replay") == 0)
+		{
+			opt.replay = argv[++i];
+			continue;
+		}
+		const long value = std::strtol(argv[i + 1], nullptr, 10);
+		if (value < 0)
+		{
+			return false;
+		}
+		if (std::strcmp(argv[i], "--tiles") == 0) opt.tiles = static_cast<int>(value);
+		else if (std::strcmp(argv[i], "--entities") == 0) opt.entities = static_cast<int>(value);
+		else if (std::strcmp(argv[i], "--bullets") == 0) opt.bullets = static_cast<int>(value);
+		else if (std::strcmp(argv[i], "--ticks") == 0) opt.ticks = static_cast<int>(value);
+		else if (std::strcmp(argv[i], "--seed") == 0) opt.seed = static_cast<unsigned>(value);
+		else if (std::strcmp(argv[i], "--threads") == 0) opt.threads = static_cast<int>(value);
+		else return false;
+		i++;
+	}
+	return opt.ticks > 0 && (!opt.record || opt.level);
+}
+
+static double peakMemoryMB()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters{};
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss / 1024.0; // ru_maxrss is in KB on Linux
+#endif
+}
+
+// a long flat level with walls at both ends and random panels to land on and shoot at
+static void createBenchLevel(const SDLState& state, GameState& gs, const Resources& res, const BenchOptions& opt, std::mt19937& rng)
+{
+	const int cols = std::max(opt.tiles, 16);
+	const float top = static_cast<float>(state.logicalHeight - MAP_ROWS * TILE_SIZE);
+	gs.tiles = TileMap(MAP_ROWS, cols, TILE_SIZE, top);
+	gs.grid.reset(gs.levelBounds());
+	setupTileTypes(gs, res);
+	for (int c = 0; c < cols; c++)
+	{
+		gs.tiles.set(TILE_LAYER_LEVEL, MAP_ROWS - 1, c, 1);
+		if (c > 0 && c < cols - 1 && rng() % 8 == 0)
+		{
+			gs.tiles.set(TILE_LAYER_LEVEL, 1 + rng() % (MAP_ROWS - 2), c, 2);
+		}
+	}
+	for (int r = 0; r < MAP_ROWS; r++)
+	{
+		gs.tiles.set(TILE_LAYER_LEVEL, r, 0, 2);
+		gs.tiles.set(TILE_LAYER_LEVEL, r, cols - 1, 2);
+	}
+
+	spawnPlayer(gs, res, glm::vec2(2 * TILE_SIZE, top));
+	for (int i = 0; i < opt.entities; i++)
+	{
+		const int c = 2 + static_cast<int>(static_cast<long long>(i) * (cols - 4) / std::max(opt.entities, 1));
+		Entity e = spawnEnemy(gs, res, glm::vec2(c * TILE_SIZE, top));
+		gs.characters.physics[gs.characters.indexOf(e)].velocity.x = rng() % 2 ? 50.0f : -50.0f;
+	}
+}
+
+// keeps the bullet count at the requested level, retired bullets get replaced by new shots from random characters
+static void topUpBullets(GameState& gs, const Resources& res, const BenchOptions& opt, std::mt19937& rng)
+{
+	while (gs.bullets.size() < static_cast<size_t>(opt.bullets))
+	{
+		const size_t shooter = rng() % gs.characters.size();
+		const float direction = rng() % 2 ? 1.0f : -1.0f;
+		const glm::vec2 position = gs.characters.transform[shooter].position + glm::vec2(TILE_SIZE / 2, TILE_SIZE / 2);
+		if (!gs.bullets.isValid(spawnBullet(gs, res, position, glm::vec2(600.0f * direction, 0), direction)))
+		{
+			break;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions opt;
+	if (!parseArgs(argc, argv, opt))
+	{
+		std::fprintf(stderr, "usage: %s [--tiles N] [--entities N] [--bullets N] [--ticks N] [--seed N] [--trace file.json] [--level file.lvl] [--threads N]"
+			" [--record file.inp] [--replay file.inp]\n", argv[0]);
+		return 1;
+	}
+
+	// no window and no renderer, input comes from our own key array instead of the keyboard
+	bool keys[SDL_SCANCODE_COUNT] = {};
+	SDLState state;
+	state.window = nullptr;
+	state.renderer = nullptr;
+	state.width = state.logicalWidth = 640;
+	state.height = state.logicalHeight = 320;
+	state.keys = keys;
+
+	Resources res;
+	res.load(state);
+	if (opt.threads > 0)
+	{
+		jobs().start(opt.threads);
+	}
+	else
+	{
+		jobs().start();
+	}
+
+	// a replay starts out exactly like the session it recorded
+	InputReplay replay;
+	if (opt.replay)
+	{
+		if (!replay.open(opt.replay) || !replay.matches(state) || replay.getTickCount() == 0)
+		{
+			std::fprintf(stderr, "can't replay %s\n", opt.replay);
+			res.unload();
+			return 1;
+		}
+		opt.level = replay.getLevelPath().c_str();
+		opt.bullets = static_cast<int>(replay.getMaxBullets());
+		opt.ticks = static_cast<int>(replay.getTickCount());
+	}
+
+	std::mt19937 rng(opt.seed);
+	GameState gs(state, std::max<size_t>(opt.bullets, 1));
+	LevelStreamer level;
+	if (opt.level)
+	{
+		if (!level.open(opt.level, state, gs, res))
+		{
+			res.unload();
+			return 1;
+		}
+	}
+	else
+	{
+		createBenchLevel(state, gs, res, opt, rng);
+	}
+	InputRecorder recorder;
+	if (opt.record && !recorder.open(opt.record, state, opt.level, std::max<size_t>(opt.bullets, 1)))
+	{
+		res.unload();
+		return 1;
+	}
+
+	const double counterFrequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	std::vector<double> tickTimes;
+	tickTimes.reserve(opt.ticks);
+	// the first second fills the pools and caches, after that a tick shouldn't allocate at all
+	const int warmupTicks = static_cast<int>(TICK_RATE);
+	uint64_t warmupAllocations = 0, steadyAllocations = 0;
+	int allocatingTicks = 0, lastAllocatingTick = -1;
+	// the game takes a snapshot after every tick for rewinding, so time that too
+	Snapshot snapshot;
+	double snapshotTime = 0;
+	for (int tick = 0; tick < opt.ticks; tick++)
+	{
+		if (replay.isOpen())
+		{
+			if (!replay.tick(state, gs))
+			{
+				break;
+			}
+		}
+		else
+		{
+			// the player runs back and forth every 4 seconds, jumps every second and never lets go of the trigger
+			const bool right = (tick / static_cast<int>(TICK_RATE * 4)) % 2 == 0;
+			keys[SDL_SCANCODE_D] = right;
+			keys[SDL_SCANCODE_A] = !right;
+			keys[SDL_SCANCODE_J] = true;
+			if (tick % static_cast<int>(TICK_RATE) == 0)
+			{
+				recorder.keyEvent(SDL_SCANCODE_K, true);
+				handleKeyInput(state, gs, gs.characters, gs.player(), SDL_SCANCODE_K, true);
+			}
+			recorder.tick(keys);
+			// extra bullets aren't input, a recording couldn't play them back
+			if (!recorder.isOpen())
+			{
+				topUpBullets(gs, res, opt, rng);
+			}
+		}
+
+		// the camera follows the player like in the game, only characters near it get their animations stepped
+		// and only the chunks around it are loaded
+		const uint64_t allocationsBefore = heapAllocationCount();
+		const uint64_t start = SDL_GetPerformanceCounter();
+		stepGame(state, gs, res, level);
+		tickTimes.push_back((SDL_GetPerformanceCounter() - start) / counterFrequency);
+		const uint64_t allocations = heapAllocationCount() - allocationsBefore;
+		if (tick < warmupTicks)
+		{
+			warmupAllocations += allocations;
+		}
+		else
+		{
+			steadyAllocations += allocations;
+			if (allocations > 0)
+			{
+				allocatingTicks++;
+				lastAllocatingTick = tick;
+			}
+		}
+		const uint64_t snapshotStart = SDL_GetPerformanceCounter();
+		snapshot.capture(gs, level, tick);
+		snapshotTime += (SDL_GetPerformanceCounter() - snapshotStart) / counterFrequency;
+		frameArena().reset();
+	}
+	recorder.close();
+
+	double total = 0;
+	for (double t : tickTimes)
+	{
+		total += t;
+	}
+	std::sort(tickTimes.begin(), tickTimes.end());
+	const double p50 = tickTimes[tickTimes.size() / 2];
+	const double p99 = tickTimes[std::min(tickTimes.size() - 1, tickTimes.size() * 99 / 100)];
+
+	std::printf("level: %d x %d tiles, characters: %zu, bullets: %d, ticks: %d, threads: %zu\n",
+		gs.tiles.getCols(), gs.tiles.getRows(), gs.characters.size(), opt.bullets, opt.ticks, jobs().threadCount());
+	std::printf("ticks/s: %.0f\n", opt.ticks / total);
+	std::printf("p50 tick: %.2f us\n", p50 * 1e6);
+	std::printf("p99 tick: %.2f us\n", p99 * 1e6);
+	std::printf("peak memory: %.1f MB\n", peakMemoryMB());
+	// a grid cell or scratch list more crowded than it ever was still grows once, a level that was seen once stays at 0
+	std::printf("heap allocations: %llu in the first %d ticks, %llu in %d ticks after that, the last in tick %d\n",
+		static_cast<unsigned long long>(warmupAllocations), warmupTicks, static_cast<unsigned long long>(steadyAllocations), allocatingTicks,
+		lastAllocatingTick);
+	const uint64_t hash = stateHash(gs);
+	const uint64_t restoreStart = SDL_GetPerformanceCounter();
+	const bool restored = snapshot.restore(gs, level);
+	const double restoreTime = (SDL_GetPerformanceCounter() - restoreStart) / counterFrequency;
+	std::printf("snapshot: %zu bytes, capture %.2f us, restore %.2f us%s\n", snapshot.size(), snapshotTime / tickTimes.size() * 1e6,
+		restoreTime * 1e6, restored && stateHash(gs) == hash ? "" : " (restoring the last tick changed the state)");
+	std::printf("state hash: %016llx\n", static_cast<unsigned long long>(hash));
+	if (opt.trace && !profiler().writeChromeTrace(opt.trace))
+	{
+		std::fprintf(stderr, "could not write %s\n", opt.trace);
+	}
+
+	level.close();
+	jobs().stop();
+	res.unload();
+	return 0;
+}
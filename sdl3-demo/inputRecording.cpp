@@ -0,0 +1,174 @@
+// inputRecording.cpp : Records and replays the keyboard input of a session, see inputRecording.h.
+//
+
+#include "inputRecording.h"
+#include "game.h"
+#include <cstring>
+
+// appends value to out as little endian bytes
+template<typename T>
+static void append(std::vector<uint8_t>& out, const T& value)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+bool InputRecorder::open(const std::string& path, const SDLState& state, const std::string& levelPath, size_t maxBullets)
+{
+	close();
+	file = SDL_IOFromFile(path.c_str(), "wb");
+	if (!file)
+	{
+		SDL_Log("Could not create recording %s: %s", path.c_str(), SDL_GetError());
+		return false;
+	}
+	header = InputFileHeader{};
+	std::memcpy(header.magic, "INP1", 4);
+	header.version = INPUT_FILE_VERSION;
+	header.tickRate = static_cast<uint32_t>(TICK_RATE);
+	header.logicalWidth = state.logicalWidth;
+	header.logicalHeight = state.logicalHeight;
+	header.maxBullets = static_cast<uint32_t>(maxBullets);
+	header.levelPathLength = static_cast<uint32_t>(levelPath.size());
+	held.fill(false);
+	pending.clear();
+	failed = SDL_WriteIO(file, &header, sizeof(header)) != sizeof(header) ||
+		SDL_WriteIO(file, levelPath.data(), levelPath.size()) != levelPath.size();
+	return !failed;
+}
+
+bool InputRecorder::close()
+{
+	if (!file)
+	{
+		return true;
+	}
+	// the header goes in again now that the tick count is known
+	failed = failed || SDL_SeekIO(file, 0, SDL_IO_SEEK_SET) != 0 || SDL_WriteIO(file, &header, sizeof(header)) != sizeof(header);
+	failed = !SDL_CloseIO(file) || failed;
+	file = nullptr;
+	if (failed)
+	{
+		SDL_Log("Could not write the recording, it will not replay");
+	}
+	return !failed;
+}
+
+void InputRecorder::keyEvent(SDL_Scancode key, bool down)
+{
+	if (file)
+	{
+		pending.push_back(static_cast<uint16_t>(key | INPUT_KEY_EVENT | (down ? INPUT_KEY_DOWN : 0)));
+	}
+}
+
+void InputRecorder::tick(const bool* keys)
+{
+	if (!file)
+	{
+		return;
+	}
+	for (int key = 0; key < SDL_SCANCODE_COUNT; key++)
+	{
+		if (keys[key] != held[key])
+		{
+			held[key] = keys[key];
+			pending.push_back(static_cast<uint16_t>(key | (keys[key] ? INPUT_KEY_DOWN : 0)));
+		}
+	}
+	if (!pending.empty())
+	{
+		record.clear();
+		append(record, header.tickCount);
+		append(record, static_cast<uint16_t>(pending.size()));
+		for (uint16_t key : pending)
+		{
+			append(record, key);
+		}
+		failed = failed || SDL_WriteIO(file, record.data(), record.size()) != record.size();
+		pending.clear();
+	}
+	header.tickCount++;
+}
+
+bool InputReplay::open(const std::string& path)
+{
+	close();
+	if (!file.open(path))
+	{
+		SDL_Log("Could not open recording %s", path.c_str());
+		return false;
+	}
+	const InputFileHeader* h = reinterpret_cast<const InputFileHeader*>(file.data());
+	if (file.size() < sizeof(InputFileHeader) || std::memcmp(h->magic, "INP1", 4) != 0 || h->version != INPUT_FILE_VERSION ||
+		h->levelPathLength > file.size() - sizeof(InputFileHeader))
+	{
+		SDL_Log("%s is not a recording this version can play", path.c_str());
+		file.close();
+		return false;
+	}
+	header = h;
+	levelPath.assign(reinterpret_cast<const char*>(file.data() + sizeof(InputFileHeader)), header->levelPathLength);
+	next = sizeof(InputFileHeader) + header->levelPathLength;
+	played = 0;
+	keys.fill(false);
+	return true;
+}
+
+void InputReplay::close()
+{
+	header = nullptr;
+	file.close();
+}
+
+bool InputReplay::matches(const SDLState& state) const
+{
+	return header->tickRate == static_cast<uint32_t>(TICK_RATE) &&
+		header->logicalWidth == static_cast<uint32_t>(state.logicalWidth) &&
+		header->logicalHeight == static_cast<uint32_t>(state.logicalHeight);
+}
+
+bool InputReplay::tick(SDLState& state, GameState& gs)
+{
+	if (!header || played >= header->tickCount)
+	{
+		return false;
+	}
+	state.keys = keys.data();
+
+	// records are in tick order, a broken one just ends the replay early
+	uint32_t recordTick;
+	uint16_t count;
+	const size_t recordHeader = sizeof(recordTick) + sizeof(count);
+	if (next + recordHeader <= file.size())
+	{
+		std::memcpy(&recordTick, file.data() + next, sizeof(recordTick));
+		std::memcpy(&count, file.data() + next + sizeof(recordTick), sizeof(count));
+		if (recordTick == played && next + recordHeader + count * sizeof(uint16_t) <= file.size())
+		{
+			const uint8_t* key = file.data() + next + recordHeader;
+			for (uint16_t k = 0; k < count; k++, key += sizeof(uint16_t))
+			{
+				uint16_t value;
+				std::memcpy(&value, key, sizeof(value));
+				const SDL_Scancode scancode = static_cast<SDL_Scancode>(value & INPUT_KEY_SCANCODE);
+				const bool down = (value & INPUT_KEY_DOWN) != 0;
+				if (scancode >= SDL_SCANCODE_COUNT)
+				{
+					continue;
+				}
+				if (value & INPUT_KEY_EVENT)
+				{
+					handleKeyInput(state, gs, gs.characters, gs.player(), scancode, down);
+				}
+				else
+				{
+					keys[scancode] = down;
+				}
+			}
+			next += recordHeader + count * sizeof(uint16_t);
+		}
+	}
+	played++;
+	return true;
+}
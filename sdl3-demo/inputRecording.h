@@ -0,0 +1,99 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mappedFile.h"
+
+struct SDLState;
+struct GameState;
+
+/*
+NOTE: The simulation only ever moves in fixed ticks and the only thing it reads from outside is the keyboard: the keys
+update() polls through state.keys and the presses that go to handleKeyInput(). Level streaming and the job system come out
+the same every run (see LevelStreamer and applyContacts()), as long as the camera follows the player's simulated position,
+which is what stepGame() does. So writing down the keyboard per tick is enough to play a session again exactly, in the
+window or headless as fast as the machine goes (sdl3-headless --replay), and compare builds on the same workload.
+Only ticks where something changed get a record, holding a key down for a minute costs the same as tapping it.
+Layout of an .inp file (little endian):
+
+	InputFileHeader
+	the path of the level that was played, levelPathLength bytes without a terminator
+	records up to the end of the file: uint32 tick, uint16 count, count x uint16 key
+
+A key is a scancode plus INPUT_KEY_DOWN if it went down (up otherwise) and INPUT_KEY_EVENT if it was a key event passed to
+handleKeyInput() rather than a change of state.keys. They apply right before the tick of their record is simulated.
+*/
+const uint32_t INPUT_FILE_VERSION = 1;
+const uint16_t INPUT_KEY_SCANCODE = 0x3FFF;
+const uint16_t INPUT_KEY_EVENT = 0x4000;
+const uint16_t INPUT_KEY_DOWN = 0x8000;
+
+struct InputFileHeader
+{
+	char magic[4]; // "INP1"
+	uint32_t version;
+	uint32_t tickCount; // ticks the session lasted, filled in when the recording is closed
+	uint32_t tickRate; // TICK_RATE it was recorded with
+	uint32_t logicalWidth, logicalHeight; // the camera size decides which chunks are active
+	uint32_t maxBullets; // size of the bullet pool, a shot is skipped when it is full
+	uint32_t levelPathLength;
+};
+static_assert(sizeof(InputFileHeader) == 32, "the level path starts 32 bytes in, keep the header that size");
+
+// writes the input of a session to an .inp file while it is played
+class InputRecorder
+{
+	SDL_IOStream* file = nullptr;
+	InputFileHeader header{};
+	std::array<bool, SDL_SCANCODE_COUNT> held{}; // state.keys as of the last recorded tick
+	std::vector<uint16_t> pending; // keys for the next tick
+	std::vector<uint8_t> record;
+	bool failed = false;
+
+public:
+	InputRecorder() = default;
+	~InputRecorder() { close(); }
+	InputRecorder(const InputRecorder&) = delete;
+	InputRecorder& operator=(const InputRecorder&) = delete;
+
+	// starts a recording of a session on levelPath, call right after the level is opened
+	bool open(const std::string& path, const SDLState& state, const std::string& levelPath, size_t maxBullets);
+	// fills in the tick count, returns false if anything couldn't be written
+	bool close();
+	bool isOpen() const { return file != nullptr; }
+
+	// call next to every handleKeyInput()
+	void keyEvent(SDL_Scancode key, bool down);
+	// call right before every tick is simulated, writes the key events since the last tick and what changed in keys
+	void tick(const bool* keys);
+};
+
+// plays an .inp file back through the same paths the keyboard takes
+class InputReplay
+{
+	MappedFile file;
+	const InputFileHeader* header = nullptr;
+	std::string levelPath;
+	std::array<bool, SDL_SCANCODE_COUNT> keys{}; // state.keys points here while the replay runs
+	size_t next = 0; // offset of the next record
+	uint32_t played = 0; // ticks handed out so far
+
+public:
+	// maps the file and checks the header, logs what is wrong otherwise
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+
+	// sets state.keys and calls handleKeyInput() the way the recorded session did before the next tick, returns false
+	// once every recorded tick was played
+	bool tick(SDLState& state, GameState& gs);
+
+	const std::string& getLevelPath() const { return levelPath; }
+	size_t getMaxBullets() const { return header->maxBullets; }
+	uint32_t getTickCount() const { return header->tickCount; }
+	uint32_t currentTick() const { return played; }
+	// false if a session recorded with other settings would play out differently here
+	bool matches(const SDLState& state) const;
+};
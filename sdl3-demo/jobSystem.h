@@ -0,0 +1,216 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+NOTE: parallelFor() cuts a loop into ranges and lets every core chew on them. Each worker owns a deque of ranges: it takes
+work from the back of its own deque, and once that is empty it steals from the front of somebody else's. The thread that
+called parallelFor() works too instead of waiting, so a loop never takes longer than running it alone would.
+The deques are fixed size rings behind a small lock each. Ranges are a few hundred entities, so a lock per range costs
+nothing next to the work inside it, and nothing in here touches the heap once the workers are running.
+Jobs only get the range and the index of the thread running them (0 is the calling thread), which is enough to hand every
+thread its own scratch memory. Anything a job wants to change outside its own range has to be collected per thread and
+applied afterwards, see applyContacts() in game.cpp.
+*/
+class JobSystem
+{
+	struct Job
+	{
+		void (*run)(const void* body, size_t begin, size_t end, size_t worker);
+		const void* body;
+		size_t begin, end;
+		std::atomic<size_t>* pending; // ranges of the parallelFor this job belongs to that aren't done yet
+	};
+	static const size_t QUEUE_SIZE = 256;
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::array<Job, QUEUE_SIZE> jobs;
+		size_t head = 0, tail = 0; // jobs[head .. tail) modulo QUEUE_SIZE, thieves take from head, the owner from tail
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues; // one per thread, [0] belongs to the thread calling parallelFor
+	std::vector<std::thread> workers;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<size_t> queued{ 0 }; // jobs sitting in any queue
+	bool stopping = false;
+
+	bool push(size_t q, const Job& job)
+	{
+		Queue& queue = *queues[q];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.tail - queue.head == QUEUE_SIZE)
+		{
+			return false;
+		}
+		queue.jobs[queue.tail++ % QUEUE_SIZE] = job;
+		queued.fetch_add(1, std::memory_order_release);
+		return true;
+	}
+	bool popBack(size_t q, Job& job)
+	{
+		Queue& queue = *queues[q];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.head == queue.tail)
+		{
+			return false;
+		}
+		job = queue.jobs[--queue.tail % QUEUE_SIZE];
+		queued.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+	bool stealFront(size_t q, Job& job)
+	{
+		Queue& queue = *queues[q];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.head == queue.tail)
+		{
+			return false;
+		}
+		job = queue.jobs[queue.head++ % QUEUE_SIZE];
+		queued.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+	// own deque first, then everybody else's starting with the next thread over
+	bool findJob(size_t self, Job& job)
+	{
+		if (popBack(self, job))
+		{
+			return true;
+		}
+		for (size_t i = 1; i < queues.size(); i++)
+		{
+			if (stealFront((self + i) % queues.size(), job))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+	static void execute(const Job& job, size_t worker)
+	{
+		job.run(job.body, job.begin, job.end, worker);
+		job.pending->fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	void work(size_t self)
+	{
+		Job job;
+		for (;;)
+		{
+			if (findJob(self, job))
+			{
+				execute(job, self);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+			if (stopping)
+			{
+				return;
+			}
+		}
+	}
+
+public:
+	JobSystem() = default;
+	~JobSystem() { stop(); }
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// threadCount includes the calling thread, 1 runs everything inline
+	void start(unsigned threadCount = std::thread::hardware_concurrency())
+	{
+		stop();
+		stopping = false;
+		const size_t count = std::max(threadCount, 1u);
+		for (size_t i = 0; i < count; i++)
+		{
+			queues.push_back(std::make_unique<Queue>());
+		}
+		for (size_t i = 1; i < count; i++)
+		{
+			workers.emplace_back(&JobSystem::work, this, i);
+		}
+	}
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+		workers.clear();
+		queues.clear();
+	}
+	size_t threadCount() const { return std::max<size_t>(queues.size(), 1); }
+
+	// calls body(begin, end, thread) for ranges of at most grain indices covering [0, count) and returns once all of them
+	// ran. Small loops run inline on the calling thread
+	template<typename F>
+	void parallelFor(size_t count, size_t grain, const F& body)
+	{
+		if (queues.size() <= 1 || count <= grain)
+		{
+			if (count > 0)
+			{
+				body(size_t(0), count, size_t(0));
+			}
+			return;
+		}
+		const auto run = [](const void* b, size_t begin, size_t end, size_t worker)
+			{
+				(*static_cast<const F*>(b))(begin, end, worker);
+			};
+		std::atomic<size_t> pending{ 0 };
+		// ranges get dealt out round robin so every worker starts with some, stealing evens out the rest
+		size_t q = 0;
+		for (size_t begin = 0; begin < count; begin += grain)
+		{
+			const Job job{ run, &body, begin, std::min(count, begin + grain), &pending };
+			pending.fetch_add(1, std::memory_order_relaxed);
+			if (!push(q, job))
+			{
+				execute(job, 0); // that deque is full, do it ourselves
+			}
+			q = (q + 1) % queues.size();
+		}
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_all();
+
+		// help out until every range of this loop is done
+		Job job;
+		while (pending.load(std::memory_order_acquire) > 0)
+		{
+			if (findJob(0, job))
+			{
+				execute(job, 0);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+};
+
+// shared by everything that wants to run in parallel. Until start() is called every parallelFor runs inline
+inline JobSystem& jobs()
+{
+	static JobSystem instance;
+	return instance;
+}
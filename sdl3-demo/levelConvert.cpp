@@ -0,0 +1,192 @@
+// levelConvert.cpp : Turns a level written as text into the binary .lvl file the game loads.
+//
+// usage: sdl3-level-convert input.txt output.lvl
+//
+// The text format is a list of layers, each one a grid of comma separated tile ids, one line per row:
+//
+//	# comments start with a hash
+//	tilesize 32
+//	layer level
+//	0, 0, P, 0, 2, ...
+//	1, 1, 1, 1, 1, ...
+//	layer background
+//	...
+//
+// Layers are background, level and foreground, a layer that isn't listed stays empty. Every layer needs the same
+// number of rows and columns. P marks where the player starts and E where an enemy starts, those cells stay empty.
+// Tile ids are the ones setupTileTypes() in game.cpp knows about.
+
+#include "levelFile.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static std::string trim(const std::string& s)
+{
+	size_t first = 0, last = s.size();
+	while (first < last && std::isspace(static_cast<unsigned char>(s[first])))
+	{
+		first++;
+	}
+	while (last > first && std::isspace(static_cast<unsigned char>(s[last - 1])))
+	{
+		last--;
+	}
+	return s.substr(first, last - first);
+}
+
+static bool parseLevel(std::istream& in, LevelContents& level)
+{
+	// rows are collected per layer first, the size of the level is only known at the end
+	std::array<std::vector<std::vector<uint8_t>>, TILE_LAYER_COUNT> grids;
+	std::vector<LevelSpawn> spawns;
+	int layer = -1;
+	std::string line;
+	for (int lineNumber = 1; std::getline(in, line); lineNumber++)
+	{
+		line = trim(line);
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+		if (line.rfind("tilesize", 0) == 0)
+		{
+			level.tileSize = std::atoi(line.c_str() + 8);
+			if (level.tileSize <= 0)
+			{
+				std::fprintf(stderr, "line %d: bad tile size\n", lineNumber);
+				return false;
+			}
+			continue;
+		}
+		if (line.rfind("layer", 0) == 0)
+		{
+			const std::string name = trim(line.substr(5));
+			layer = name == "background" ? static_cast<int>(TILE_LAYER_BACKGROUND) :
+				name == "level" ? static_cast<int>(TILE_LAYER_LEVEL) :
+				name == "foreground" ? static_cast<int>(TILE_LAYER_FOREGROUND) : -1;
+			if (layer < 0)
+			{
+				std::fprintf(stderr, "line %d: unknown layer '%s'\n", lineNumber, name.c_str());
+				return false;
+			}
+			if (!grids[layer].empty())
+			{
+				std::fprintf(stderr, "line %d: layer '%s' is listed twice\n", lineNumber, name.c_str());
+				return false;
+			}
+			continue;
+		}
+		if (layer < 0)
+		{
+			std::fprintf(stderr, "line %d: tiles before the first layer line\n", lineNumber);
+			return false;
+		}
+
+		std::vector<uint8_t> row;
+		std::stringstream cells(line);
+		std::string cell;
+		while (std::getline(cells, cell, ','))
+		{
+			cell = trim(cell);
+			if (cell.empty())
+			{
+				continue; // trailing comma
+			}
+			const int r = static_cast<int>(grids[layer].size());
+			const int c = static_cast<int>(row.size());
+			if (cell == "P" || cell == "E")
+			{
+				spawns.push_back(LevelSpawn{ cell == "P" ? LevelSpawnType::player : LevelSpawnType::enemy, {}, r, c });
+				row.push_back(0);
+				continue;
+			}
+			char* end = nullptr;
+			const long id = std::strtol(cell.c_str(), &end, 10);
+			if (*end != '\0' || id < 0 || id > 255)
+			{
+				std::fprintf(stderr, "line %d: '%s' is not a tile id\n", lineNumber, cell.c_str());
+				return false;
+			}
+			row.push_back(static_cast<uint8_t>(id));
+		}
+		grids[layer].push_back(std::move(row));
+	}
+
+	level.rows = level.cols = 0;
+	for (size_t l = 0; l < TILE_LAYER_COUNT; l++)
+	{
+		if (grids[l].empty())
+		{
+			continue;
+		}
+		if (level.rows == 0)
+		{
+			level.rows = static_cast<int>(grids[l].size());
+			level.cols = static_cast<int>(grids[l][0].size());
+		}
+		if (static_cast<int>(grids[l].size()) != level.rows)
+		{
+			std::fprintf(stderr, "every layer needs %d rows\n", level.rows);
+			return false;
+		}
+		level.layers[l].reserve(static_cast<size_t>(level.rows) * level.cols);
+		for (const std::vector<uint8_t>& row : grids[l])
+		{
+			if (static_cast<int>(row.size()) != level.cols)
+			{
+				std::fprintf(stderr, "every row needs %d columns\n", level.cols);
+				return false;
+			}
+			level.layers[l].insert(level.layers[l].end(), row.begin(), row.end());
+		}
+	}
+	if (level.rows == 0 || level.cols == 0)
+	{
+		std::fprintf(stderr, "the level has no tiles\n");
+		return false;
+	}
+	size_t players = 0;
+	for (const LevelSpawn& spawn : spawns)
+	{
+		players += spawn.type == LevelSpawnType::player;
+	}
+	if (players != 1)
+	{
+		std::fprintf(stderr, "the level needs exactly one P, it has %zu\n", players);
+		return false;
+	}
+	level.spawns = std::move(spawns);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "usage: %s input.txt output.lvl\n", argv[0]);
+		return 1;
+	}
+	std::ifstream in(argv[1]);
+	if (!in)
+	{
+		std::fprintf(stderr, "could not open %s\n", argv[1]);
+		return 1;
+	}
+	LevelContents level;
+	if (!parseLevel(in, level))
+	{
+		return 1;
+	}
+	if (!writeLevelFile(argv[2], level))
+	{
+		std::fprintf(stderr, "could not write %s\n", argv[2]);
+		return 1;
+	}
+	std::printf("%s: %d x %d tiles, %zu spawns\n", argv[2], level.cols, level.rows, level.spawns.size());
+	return 0;
+}
@@ -0,0 +1,217 @@
+// levelFile.cpp : Reads and writes the binary .lvl level format.
+//
+
+#include "levelFile.h"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cstring>
+
+// true if size bytes at offset are inside a file of fileSize bytes and start on a 4 byte boundary
+static bool inside(size_t fileSize, uint64_t offset, uint64_t size)
+{
+	return offset % 4 == 0 && offset <= fileSize && size <= fileSize - offset;
+}
+
+bool LevelFile::open(const std::string& path)
+{
+	header = nullptr;
+	layers = nullptr;
+	if (!file.open(path))
+	{
+		SDL_Log("Could not open level %s", path.c_str());
+		return false;
+	}
+	const auto fail = [this, &path](const char* reason)
+		{
+			SDL_Log("Level %s is broken: %s", path.c_str(), reason);
+			file.close();
+			return false;
+		};
+	if (file.size() < sizeof(LevelFileHeader))
+	{
+		return fail("too small");
+	}
+	const LevelFileHeader* h = reinterpret_cast<const LevelFileHeader*>(file.data());
+	if (std::memcmp(h->magic, "LVL1", 4) != 0 || h->version != LEVEL_FILE_VERSION)
+	{
+		return fail("not a level file or written by a different version");
+	}
+	if (h->rows == 0 || h->cols == 0 || h->rows > 0xFFFF || h->cols > 0x1000000 || h->tileSize == 0 || h->chunkCols == 0)
+	{
+		return fail("bad size");
+	}
+	if (h->layerCount != TILE_LAYER_COUNT || !inside(file.size(), sizeof(LevelFileHeader), sizeof(LevelLayerEntry) * h->layerCount))
+	{
+		return fail("bad layer table");
+	}
+	if (!inside(file.size(), h->spawnOffset, sizeof(LevelSpawn) * static_cast<uint64_t>(h->spawnCount)))
+	{
+		return fail("bad spawn list");
+	}
+	header = h;
+	layers = reinterpret_cast<const LevelLayerEntry*>(file.data() + sizeof(LevelFileHeader));
+
+	const uint64_t chunks = chunkCount();
+	for (size_t layer = 0; layer < TILE_LAYER_COUNT; layer++)
+	{
+		const LevelLayerEntry& entry = layers[layer];
+		if (!inside(file.size(), entry.directoryOffset, (chunks + 1) * sizeof(uint32_t)) ||
+			!inside(file.size(), entry.runsOffset, entry.runsSize))
+		{
+			header = nullptr;
+			return fail("bad chunk directory");
+		}
+		// offsets only ever grow, so checking them once here means decodeChunk can trust them
+		const uint32_t* offsets = directory(layer);
+		for (uint64_t chunk = 0; chunk < chunks; chunk++)
+		{
+			if (offsets[chunk] > offsets[chunk + 1] || offsets[chunk + 1] > entry.runsSize || (offsets[chunk + 1] - offsets[chunk]) % 2 != 0)
+			{
+				header = nullptr;
+				return fail("bad chunk directory");
+			}
+		}
+	}
+	for (size_t i = 0; i < header->spawnCount; i++)
+	{
+		const LevelSpawn& spawn = spawns()[i];
+		if (spawn.row < 0 || spawn.row >= getRows() || spawn.col < 0 || spawn.col >= getCols() ||
+			(spawn.type != LevelSpawnType::player && spawn.type != LevelSpawnType::enemy))
+		{
+			header = nullptr;
+			return fail("bad spawn");
+		}
+	}
+	return true;
+}
+
+bool LevelFile::decodeChunk(size_t layer, int chunk, uint8_t* cells, int stride) const
+{
+	const int first = chunk * getChunkCols();
+	const int width = std::min(getChunkCols(), getCols() - first);
+	const uint32_t* offsets = directory(layer);
+	const uint8_t* run = file.data() + layers[layer].runsOffset + offsets[chunk];
+	const uint8_t* end = file.data() + layers[layer].runsOffset + offsets[chunk + 1];
+
+	if (width < stride)
+	{
+		std::fill_n(cells, static_cast<size_t>(getRows()) * stride, 0);
+	}
+
+	// runs go row by row through the chunk and may carry on into the next row
+	int r = 0, c = 0;
+	for (; run < end; run += 2)
+	{
+		int count = run[0];
+		const uint8_t id = run[1];
+		while (count > 0)
+		{
+			if (r >= getRows())
+			{
+				return false; // more cells than the chunk has
+			}
+			const int n = std::min(count, width - c);
+			std::fill_n(cells + static_cast<size_t>(r) * stride + c, n, id);
+			count -= n;
+			c += n;
+			if (c == width)
+			{
+				c = 0;
+				r++;
+			}
+		}
+	}
+	return r == getRows();
+}
+
+// appends value to out as little endian bytes
+template<typename T>
+static void append(std::vector<uint8_t>& out, const T& value)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+static void alignTo4(std::vector<uint8_t>& out)
+{
+	out.resize((out.size() + 3) & ~static_cast<size_t>(3), 0);
+}
+
+bool writeLevelFile(const std::string& path, const LevelContents& level, int chunkCols)
+{
+	if (level.rows <= 0 || level.cols <= 0 || chunkCols <= 0)
+	{
+		return false;
+	}
+	const int chunks = (level.cols + chunkCols - 1) / chunkCols;
+	std::vector<uint8_t> out;
+	LevelFileHeader header{};
+	std::memcpy(header.magic, "LVL1", 4);
+	header.version = LEVEL_FILE_VERSION;
+	header.rows = level.rows;
+	header.cols = level.cols;
+	header.tileSize = level.tileSize;
+	header.chunkCols = chunkCols;
+	header.layerCount = TILE_LAYER_COUNT;
+	header.spawnCount = static_cast<uint32_t>(level.spawns.size());
+	append(out, header);
+	const size_t layerTable = out.size();
+	out.resize(out.size() + sizeof(LevelLayerEntry) * TILE_LAYER_COUNT, 0);
+
+	for (size_t layer = 0; layer < TILE_LAYER_COUNT; layer++)
+	{
+		const std::vector<uint8_t>& cells = level.layers[layer];
+		LevelLayerEntry entry{};
+		entry.directoryOffset = static_cast<uint32_t>(out.size());
+		out.resize(out.size() + (chunks + 1) * sizeof(uint32_t), 0);
+		entry.runsOffset = static_cast<uint32_t>(out.size());
+
+		std::vector<uint32_t> offsets;
+		for (int chunk = 0; chunk < chunks; chunk++)
+		{
+			offsets.push_back(static_cast<uint32_t>(out.size() - entry.runsOffset));
+			const int first = chunk * chunkCols;
+			const int last = std::min(level.cols, first + chunkCols);
+			uint8_t runId = 0;
+			int runLength = 0;
+			for (int r = 0; r < level.rows; r++)
+			{
+				for (int c = first; c < last; c++)
+				{
+					const uint8_t id = cells.empty() ? 0 : cells[static_cast<size_t>(r) * level.cols + c];
+					if (runLength > 0 && (id != runId || runLength == 255))
+					{
+						out.push_back(static_cast<uint8_t>(runLength));
+						out.push_back(runId);
+						runLength = 0;
+					}
+					runId = id;
+					runLength++;
+				}
+			}
+			out.push_back(static_cast<uint8_t>(runLength));
+			out.push_back(runId);
+		}
+		offsets.push_back(static_cast<uint32_t>(out.size() - entry.runsOffset));
+		entry.runsSize = offsets.back();
+		std::memcpy(out.data() + entry.directoryOffset, offsets.data(), offsets.size() * sizeof(uint32_t));
+		std::memcpy(out.data() + layerTable + layer * sizeof(LevelLayerEntry), &entry, sizeof(entry));
+		alignTo4(out);
+	}
+
+	header.spawnOffset = static_cast<uint32_t>(out.size());
+	std::memcpy(out.data(), &header, sizeof(header));
+	for (const LevelSpawn& spawn : level.spawns)
+	{
+		append(out, spawn);
+	}
+	// written under a temporary name and renamed over the old file, a game that has it mapped keeps reading the old
+	// contents instead of having them cut short underneath it, and file watchers see one complete new file
+	const std::string temporary = path + ".tmp";
+	if (!SDL_SaveFile(temporary.c_str(), out.data(), out.size()) || !SDL_RenamePath(temporary.c_str(), path.c_str()))
+	{
+		SDL_Log("Could not write %s: %s", path.c_str(), SDL_GetError());
+		SDL_RemovePath(temporary.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mappedFile.h"
+#include "tileMap.h"
+
+/*
+NOTE: Levels are stored in a small binary format that gets memory mapped and read in place, nothing is parsed into
+temporary objects first. Layout of a .lvl file (little endian, every table starts on a 4 byte boundary):
+
+	LevelFileHeader
+	LevelLayerEntry[layerCount]
+	per layer: uint32 chunk directory with chunkCount + 1 offsets, then the runs of every chunk back to back
+	LevelSpawn[spawnCount]
+
+The columns are cut into chunks of chunkCols. The cells of a chunk are read row by row and stored as runs of
+(count, tile id) byte pairs, long stretches of sky or ground shrink to a couple of bytes. The chunk directory says where
+each chunk's runs start, so a single chunk can be decoded without touching the rest of the level.
+Levels are written by sdl3-level-convert from a text file, see levelConvert.cpp.
+*/
+const uint32_t LEVEL_FILE_VERSION = 1;
+
+struct LevelFileHeader
+{
+	char magic[4]; // "LVL1"
+	uint32_t version;
+	uint32_t rows, cols;
+	uint32_t tileSize;
+	uint32_t chunkCols; // columns per chunk of run data
+	uint32_t layerCount;
+	uint32_t spawnCount;
+	uint32_t spawnOffset; // where the spawn list starts, from the start of the file
+	uint32_t reserved[3];
+};
+static_assert(sizeof(LevelFileHeader) == 48, "the layer table starts 48 bytes in, keep the header that size");
+
+struct LevelLayerEntry
+{
+	uint32_t directoryOffset; // chunk directory of the layer, from the start of the file
+	uint32_t runsOffset; // first run of chunk 0, the directory offsets are relative to this
+	uint32_t runsSize;
+	uint32_t reserved;
+};
+
+enum class LevelSpawnType : uint8_t
+{
+	player = 0,
+	enemy = 1,
+};
+
+struct LevelSpawn
+{
+	LevelSpawnType type;
+	uint8_t reserved[3];
+	int32_t row, col; // cell the character starts in
+};
+static_assert(sizeof(LevelSpawn) == 12, "spawns are read straight from the file");
+
+// a level that is mapped into memory, everything handed out points into the mapping and lives as long as the object
+class LevelFile
+{
+	MappedFile file;
+	const LevelFileHeader* header = nullptr;
+	const LevelLayerEntry* layers = nullptr;
+
+	const uint32_t* directory(size_t layer) const
+	{
+		return reinterpret_cast<const uint32_t*>(file.data() + layers[layer].directoryOffset);
+	}
+
+public:
+	// maps the file and checks that every table in it is where the header says, logs what is wrong otherwise
+	bool open(const std::string& path);
+	void close()
+	{
+		header = nullptr;
+		layers = nullptr;
+		file.close();
+	}
+
+	int getRows() const { return static_cast<int>(header->rows); }
+	int getCols() const { return static_cast<int>(header->cols); }
+	float getTileSize() const { return static_cast<float>(header->tileSize); }
+	int getChunkCols() const { return static_cast<int>(header->chunkCols); }
+	int chunkCount() const { return static_cast<int>((header->cols + header->chunkCols - 1) / header->chunkCols); }
+
+	const LevelSpawn* spawns() const { return reinterpret_cast<const LevelSpawn*>(file.data() + header->spawnOffset); }
+	size_t spawnCount() const { return header->spawnCount; }
+
+	// writes the cells of one chunk of a layer into cells, row r starts at cells + r * stride, stride >= getChunkCols()
+	// columns past the end of the level come out empty. Only reads the mapping, so any thread can call it
+	bool decodeChunk(size_t layer, int chunk, uint8_t* cells, int stride) const;
+};
+
+// everything the converter collects before writing a .lvl file, one byte per cell and layer like in TileMap
+struct LevelContents
+{
+	int rows = 0, cols = 0;
+	int tileSize = 32;
+	std::array<std::vector<uint8_t>, TILE_LAYER_COUNT> layers;
+	std::vector<LevelSpawn> spawns;
+};
+
+bool writeLevelFile(const std::string& path, const LevelContents& level, int chunkCols = TILE_CHUNK_COLS);
@@ -0,0 +1,471 @@
+// levelStreamer.cpp : Keeps the part of the level around the camera loaded, see levelStreamer.h.
+//
+
+#include "levelStreamer.h"
+#include "game.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+bool LevelStreamer::open(const std::string& levelPath, const SDLState& state, GameState& gs, const Resources& res)
+{
+	close();
+	const uint64_t start = SDL_GetPerformanceCounter();
+	std::shared_ptr<LevelFile> file = std::make_shared<LevelFile>();
+	if (!file->open(levelPath))
+	{
+		return false;
+	}
+	if (file->getChunkCols() != TILE_CHUNK_COLS)
+	{
+		SDL_Log("Level %s has %d columns per chunk, streaming needs %d", levelPath.c_str(), file->getChunkCols(), TILE_CHUNK_COLS);
+		return false;
+	}
+	level = std::move(file);
+	generation = 0;
+	path = levelPath;
+
+	// the level sits on the bottom of the screen, every chunk starts out unloaded
+	const float top = state.logicalHeight - level->getRows() * level->getTileSize();
+	gs.tiles = TileMap(level->getRows(), level->getCols(), level->getTileSize(), top, false);
+	gs.grid.reset(gs.levelBounds());
+	setupTileTypes(gs, res);
+	cellCount = gs.tiles.chunkCellCount();
+	const int chunks = level->chunkCount();
+	states.assign(chunks, ChunkState::unloaded);
+	resident.clear();
+	evicted.clear();
+
+	indexSpawns();
+	spawned.assign(level->spawnCount(), Entity{ UINT32_MAX, 0 });
+
+	// the player is the only character that exists no matter where the camera is
+	const LevelSpawn* spawns = level->spawns();
+	for (size_t i = 0; i < level->spawnCount(); i++)
+	{
+		if (spawns[i].type == LevelSpawnType::player)
+		{
+			const SDL_FRect cell = gs.tiles.tileRect(spawns[i].row, spawns[i].col);
+			spawned[i] = spawnPlayer(gs, res, glm::vec2(cell.x, cell.y));
+			break;
+		}
+	}
+	if (!gs.characters.isValid(gs.playerEntity))
+	{
+		SDL_Log("Level %s has no player", levelPath.c_str());
+		close();
+		return false;
+	}
+
+	stopping = false;
+	worker = std::thread(&LevelStreamer::work, this);
+	// the camera starts out centred on the player like in the game loop
+	gs.mapViewport.x = (gs.characters.transform[gs.player()].position.x + TILE_SIZE / 2) - gs.mapViewport.w / 2;
+	update(gs, res);
+	SDL_Log("Opened level %s, %d x %d tiles in %d chunks, %zu loaded around the player in %.2f ms", levelPath.c_str(),
+		level->getCols(), level->getRows(), chunks, resident.size(), (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+	return true;
+}
+
+void LevelStreamer::close()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	if (worker.joinable())
+	{
+		worker.join();
+	}
+	requests.clear();
+	finished.clear();
+	spareCells.clear();
+	states.clear();
+	resident.clear();
+	spawnStart.clear();
+	spawnOrder.clear();
+	spawned.clear();
+	reloaded.reset();
+	reloadRequested = false;
+	level.reset();
+}
+
+void LevelStreamer::reload()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		reloadRequested = true;
+	}
+	wake.notify_all();
+}
+
+// buckets the spawns by chunk so activating a chunk only looks at its own
+void LevelStreamer::indexSpawns()
+{
+	const LevelSpawn* spawns = level->spawns();
+	const int chunks = level->chunkCount();
+	spawnStart.assign(chunks + 1, 0);
+	for (size_t i = 0; i < level->spawnCount(); i++)
+	{
+		spawnStart[spawns[i].col / TILE_CHUNK_COLS + 1]++;
+	}
+	for (int chunk = 0; chunk < chunks; chunk++)
+	{
+		spawnStart[chunk + 1] += spawnStart[chunk];
+	}
+	std::vector<uint32_t> next(spawnStart.begin(), spawnStart.end() - 1);
+	spawnOrder.resize(level->spawnCount());
+	for (size_t i = 0; i < level->spawnCount(); i++)
+	{
+		spawnOrder[next[spawns[i].col / TILE_CHUNK_COLS]++] = static_cast<uint32_t>(i);
+	}
+}
+
+void LevelStreamer::work()
+{
+	for (;;)
+	{
+		int chunk = -1;
+		std::shared_ptr<const LevelFile> file;
+		uint32_t fileGeneration;
+		std::vector<uint8_t> cells;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || reloadRequested || !requests.empty(); });
+			if (stopping)
+			{
+				return;
+			}
+			if (reloadRequested)
+			{
+				reloadRequested = false;
+			}
+			else
+			{
+				chunk = requests.back();
+				requests.pop_back();
+				cells = takeSpareCells();
+			}
+			file = level;
+			fileGeneration = generation;
+		}
+		if (chunk < 0)
+		{
+			// mapping and checking a big level takes a while, the simulation only has to switch pointers once this is done
+			std::shared_ptr<LevelFile> opened = std::make_shared<LevelFile>();
+			if (!opened->open(path))
+			{
+				SDL_Log("Level %s changed but can't be opened, keeping the old version", path.c_str());
+				continue;
+			}
+			std::lock_guard<std::mutex> lock(mutex);
+			reloaded = std::move(opened);
+			continue;
+		}
+		decode(*file, chunk, cells);
+		std::lock_guard<std::mutex> lock(mutex);
+		finished.push_back(Decoded{ chunk, fileGeneration, std::move(cells) });
+	}
+}
+
+// mutex has to be held
+std::vector<uint8_t> LevelStreamer::takeSpareCells()
+{
+	if (spareCells.empty())
+	{
+		return std::vector<uint8_t>(cellCount, 0);
+	}
+	std::vector<uint8_t> cells = std::move(spareCells.back());
+	spareCells.pop_back();
+	return cells;
+}
+
+// fills cells with every layer of chunk in the tile map's layout, a broken chunk comes out empty
+bool LevelStreamer::decode(const LevelFile& file, int chunk, std::vector<uint8_t>& cells) const
+{
+	const size_t layerSize = static_cast<size_t>(file.getRows()) * TILE_CHUNK_COLS;
+	for (size_t layer = 0; layer < TILE_LAYER_COUNT; layer++)
+	{
+		if (!file.decodeChunk(layer, chunk, cells.data() + layer * layerSize, TILE_CHUNK_COLS))
+		{
+			SDL_Log("Level %s is broken: chunk %d of layer %zu doesn't add up", path.c_str(), chunk, layer);
+			std::fill(cells.begin(), cells.end(), 0);
+			return false;
+		}
+	}
+	return true;
+}
+
+void LevelStreamer::loadNow(GameState& gs, int chunk)
+{
+	std::vector<uint8_t> cells;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		cells = takeSpareCells();
+	}
+	decode(*level, chunk, cells);
+	gs.tiles.loadChunk(chunk, cells);
+	states[chunk] = ChunkState::loaded;
+	resident.push_back(chunk);
+}
+
+void LevelStreamer::activate(GameState& gs, const Resources& res, int chunk)
+{
+	for (uint32_t k = spawnStart[chunk]; k < spawnStart[chunk + 1]; k++)
+	{
+		const uint32_t i = spawnOrder[k];
+		const LevelSpawn& spawn = level->spawns()[i];
+		if (spawn.type == LevelSpawnType::enemy && !gs.characters.isValid(spawned[i]))
+		{
+			const SDL_FRect cell = gs.tiles.tileRect(spawn.row, spawn.col);
+			spawned[i] = spawnEnemy(gs, res, glm::vec2(cell.x, cell.y));
+		}
+	}
+	states[chunk] = ChunkState::active;
+}
+
+// switches to a new version of the level file, only the loaded chunks whose tiles changed are loaded again
+void LevelStreamer::switchLevel(GameState& gs, std::shared_ptr<const LevelFile> file)
+{
+	PROFILE_ZONE("level reload");
+	if (file->getRows() != level->getRows() || file->getCols() != level->getCols() || file->getTileSize() != level->getTileSize() ||
+		file->getChunkCols() != level->getChunkCols() || file->spawnCount() != level->spawnCount())
+	{
+		SDL_Log("Level %s changed its size or number of spawns, restart to play the new version", path.c_str());
+		return;
+	}
+	{
+		// the worker may still be decoding from the old file, it keeps the mapping alive until it is done
+		std::lock_guard<std::mutex> lock(mutex);
+		level.swap(file);
+		generation++;
+	}
+	indexSpawns();
+	size_t changed = 0;
+	reloadCells.resize(cellCount);
+	for (int chunk : resident)
+	{
+		decode(*level, chunk, reloadCells);
+		if (reloadCells != gs.tiles.chunkCells(chunk))
+		{
+			gs.tiles.loadChunk(chunk, reloadCells); // the old block comes back, good enough as scratch for the next chunk
+			changed++;
+		}
+	}
+	SDL_Log("Reloaded level %s, %zu of %zu loaded chunks changed", path.c_str(), changed, resident.size());
+}
+
+int LevelStreamer::chunkAt(float x) const
+{
+	return static_cast<int>(std::floor(x / (TILE_CHUNK_COLS * level->getTileSize())));
+}
+
+void LevelStreamer::update(GameState& gs, const Resources& res)
+{
+	PROFILE_ZONE("level streaming");
+	evicted.clear();
+	if (states.empty())
+	{
+		return;
+	}
+	const int lastChunk = static_cast<int>(states.size()) - 1;
+	const int activeFirst = chunkAt(gs.mapViewport.x) - ACTIVE_MARGIN;
+	const int activeLast = chunkAt(gs.mapViewport.x + gs.mapViewport.w) + ACTIVE_MARGIN;
+	int loadFirst = activeFirst - LOAD_MARGIN;
+	int loadLast = activeLast + LOAD_MARGIN;
+	const float playerVelocity = gs.characters.physics[gs.player()].velocity.x;
+	if (playerVelocity > 0)
+	{
+		loadLast += PREFETCH_CHUNKS;
+	}
+	else if (playerVelocity < 0)
+	{
+		loadFirst -= PREFETCH_CHUNKS;
+	}
+
+	// swap in whatever the worker finished, chunks that stopped being wanted in the meantime just give their block back
+	std::shared_ptr<const LevelFile> file;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		arrived.swap(finished);
+		file.swap(reloaded);
+	}
+	if (file)
+	{
+		switchLevel(gs, std::move(file));
+	}
+	for (Decoded& decoded : arrived)
+	{
+		if (states[decoded.chunk] == ChunkState::queued && decoded.generation != generation)
+		{
+			states[decoded.chunk] = ChunkState::unloaded; // decoded from the file before a reload, asked for again below
+		}
+		else if (states[decoded.chunk] == ChunkState::queued)
+		{
+			gs.tiles.loadChunk(decoded.chunk, decoded.cells);
+			states[decoded.chunk] = ChunkState::loaded;
+			resident.push_back(decoded.chunk);
+		}
+	}
+
+	// anything an active chunk's characters can touch has to be there this frame, waiting for the worker isn't an option
+	for (int chunk = std::max(0, activeFirst - 1); chunk <= std::min(lastChunk, activeLast + 1); chunk++)
+	{
+		if (states[chunk] == ChunkState::unloaded || states[chunk] == ChunkState::queued)
+		{
+			loadNow(gs, chunk);
+		}
+	}
+	for (int chunk = std::max(0, activeFirst); chunk <= std::min(lastChunk, activeLast); chunk++)
+	{
+		if (states[chunk] == ChunkState::loaded)
+		{
+			activate(gs, res, chunk);
+		}
+	}
+
+	// deactivate and drop what the camera left behind
+	std::unique_lock<std::mutex> lock(mutex);
+	for (Decoded& decoded : arrived)
+	{
+		if (decoded.cells.size() == cellCount)
+		{
+			spareCells.push_back(std::move(decoded.cells));
+		}
+	}
+	arrived.clear();
+	for (size_t k = 0; k < resident.size();)
+	{
+		const int chunk = resident[k];
+		if (states[chunk] == ChunkState::active && (chunk < activeFirst - HYSTERESIS || chunk > activeLast + HYSTERESIS))
+		{
+			states[chunk] = ChunkState::loaded;
+		}
+		if (chunk < loadFirst - HYSTERESIS || chunk > loadLast + HYSTERESIS)
+		{
+			spareCells.emplace_back();
+			gs.tiles.unloadChunk(chunk, spareCells.back());
+			states[chunk] = ChunkState::unloaded;
+			evicted.push_back(chunk);
+			resident[k] = resident.back();
+			resident.pop_back();
+			continue;
+		}
+		k++;
+	}
+
+	// hand the worker what is still missing, nearest to the camera first. Requests it didn't get to yet are dropped,
+	// the camera may have moved on since. Some of them were loaded right away above and have to stay that way
+	for (int chunk : requests)
+	{
+		if (states[chunk] == ChunkState::queued)
+		{
+			states[chunk] = ChunkState::unloaded;
+		}
+	}
+	requests.clear();
+	const int middle = chunkAt(gs.mapViewport.x + gs.mapViewport.w / 2);
+	for (int chunk = std::max(0, loadFirst); chunk <= std::min(lastChunk, loadLast); chunk++)
+	{
+		if (states[chunk] == ChunkState::unloaded)
+		{
+			states[chunk] = ChunkState::queued;
+			requests.push_back(chunk);
+		}
+	}
+	std::sort(requests.begin(), requests.end(), [middle](int a, int b) { return std::abs(a - middle) > std::abs(b - middle); });
+	const bool anyRequests = !requests.empty();
+	lock.unlock();
+	if (anyRequests)
+	{
+		wake.notify_one();
+	}
+	removeOutsideActive(gs);
+}
+
+void LevelStreamer::capture(SnapshotWriter& out) const
+{
+	out.write(static_cast<uint32_t>(states.size()));
+	out.write(static_cast<uint32_t>(spawned.size()));
+	uint32_t activeCount = 0;
+	for (int chunk : resident)
+	{
+		activeCount += states[chunk] == ChunkState::active;
+	}
+	out.write(activeCount);
+	for (int chunk : resident)
+	{
+		if (states[chunk] == ChunkState::active)
+		{
+			out.write(static_cast<int32_t>(chunk));
+		}
+	}
+	out.write(spawned.data(), spawned.size());
+}
+
+bool LevelStreamer::restore(SnapshotReader& in, GameState& gs)
+{
+	uint32_t chunkCount, spawnCount, activeCount;
+	if (!in.read(chunkCount) || !in.read(spawnCount) || !in.read(activeCount) ||
+		chunkCount != states.size() || spawnCount != spawned.size() || activeCount > chunkCount)
+	{
+		return false;
+	}
+	restored.resize(activeCount);
+	if (!in.read(restored.data(), activeCount) || !in.read(spawned.data(), spawnCount))
+	{
+		return false;
+	}
+	for (int chunk : resident)
+	{
+		if (states[chunk] == ChunkState::active)
+		{
+			states[chunk] = ChunkState::loaded;
+		}
+	}
+	for (int32_t chunk : restored)
+	{
+		if (chunk < 0 || chunk >= static_cast<int32_t>(chunkCount))
+		{
+			continue;
+		}
+		// same as in update(), a queued chunk the worker delivers later just gives its block back
+		if (states[chunk] == ChunkState::unloaded || states[chunk] == ChunkState::queued)
+		{
+			loadNow(gs, chunk);
+		}
+		states[chunk] = ChunkState::active;
+	}
+	return true;
+}
+
+// characters and bullets are only simulated in active chunks, whatever wandered or flew out of them goes
+void LevelStreamer::removeOutsideActive(GameState& gs)
+{
+	const auto isActive = [this](const SDL_FRect& rect)
+		{
+			const int chunk = chunkAt(rect.x + rect.w / 2);
+			return chunk >= 0 && chunk < static_cast<int>(states.size()) && states[chunk] == ChunkState::active;
+		};
+	size_t i = 0;
+	while (i < gs.characters.size())
+	{
+		if (gs.characters.type[i] == ObjectType::enemy && !isActive(gs.characters.worldCollider(i)))
+		{
+			destroyCharacter(gs, i); // the last character was moved into slot i, so look at i again
+		}
+		else
+		{
+			i++;
+		}
+	}
+	for (i = 0; i < gs.bullets.size(); i++)
+	{
+		if (gs.bullets.data[i].bullet.state == BulletState::moving && !isActive(gs.bullets.worldCollider(i)))
+		{
+			gs.bullets.data[i].bullet.state = BulletState::inactive;
+		}
+	}
+}
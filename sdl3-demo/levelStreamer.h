@@ -0,0 +1,124 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gameObject.h"
+#include "levelFile.h"
+#include "tileMap.h"
+
+struct SDLState;
+struct GameState;
+struct Resources;
+class SnapshotWriter;
+class SnapshotReader;
+
+/*
+NOTE: A long level doesn't need to be in memory all at once, only the part around the camera matters. The level is
+cut into the same TILE_CHUNK_COLS wide chunks the tile map and the .lvl file use, and every chunk goes through:
+
+	unloaded -> queued -> loaded (tiles are in the map) -> active (its enemies are spawned and simulated)
+
+Chunks under the camera plus ACTIVE_MARGIN on each side are active. LOAD_MARGIN more on each side are kept loaded, and
+PREFETCH_CHUNKS extra ones in the direction the player is running so they are ready before the camera gets there.
+Decoding happens on a worker thread, the main thread only swaps finished chunks into the tile map. A chunk that has to
+be active but isn't loaded yet (the player teleported, the worker fell behind) gets decoded right away on the main thread,
+decoding a chunk takes microseconds.
+Things are only deactivated or dropped HYSTERESIS chunks past the edge where they would be loaded, so running back and forth
+over a border doesn't reload the same chunk every frame. Enemies in a chunk that isn't active are removed, and spawned
+again from the level file when the chunk becomes active again (unless the one from last time is still around).
+All of this keeps the tile memory and the number of characters and bullets the simulation loops over bounded by the
+size of the screen instead of the size of the level.
+When the .lvl file changes on disk, reload() has the worker map and check the new file. The next update() switches to it
+and loads the new contents of only those loaded chunks whose tiles changed. Nothing else is touched: characters stay where
+they are, and moved spawn points are used the next time their chunk becomes active. A file with another size or number
+of spawns needs a restart. The worker keeps its own reference to the file it is decoding, so the old mapping stays
+valid until the worker is done with it.
+*/
+class LevelStreamer
+{
+public:
+	static const int ACTIVE_MARGIN = 1;
+	static const int LOAD_MARGIN = 2;
+	static const int PREFETCH_CHUNKS = 4;
+	static const int HYSTERESIS = 1;
+
+private:
+	enum class ChunkState : uint8_t
+	{
+		unloaded, queued, loaded, active
+	};
+	struct Decoded
+	{
+		int chunk;
+		uint32_t generation; // of the file it was decoded from
+		std::vector<uint8_t> cells;
+	};
+
+	std::shared_ptr<const LevelFile> level;
+	uint32_t generation = 0; // counts the files reload() switched to
+	std::string path;
+	size_t cellCount = 0; // bytes per chunk, TileMap::chunkCellCount()
+	std::vector<ChunkState> states;
+	std::vector<int> resident; // chunks that are loaded or active, so nothing has to walk every chunk of the level
+	std::vector<uint32_t> spawnStart; // spawns of chunk k are spawnOrder[spawnStart[k] .. spawnStart[k + 1])
+	std::vector<uint32_t> spawnOrder; // indices into the level's spawn list, sorted by chunk
+	std::vector<Entity> spawned; // character created from each spawn, so a chunk coming back doesn't spawn it twice
+	std::vector<int> evicted; // chunks dropped by the last update()
+	std::vector<Decoded> arrived; // scratch list for chunks the worker finished
+	std::vector<int32_t> restored; // scratch list for the active chunks of a snapshot
+	std::vector<uint8_t> reloadCells; // scratch block for comparing chunks after a reload
+
+	std::thread worker;
+	std::mutex mutex; // guards everything below
+	std::condition_variable wake;
+	std::vector<int> requests; // chunks the worker should decode, the nearest one is at the back
+	std::vector<Decoded> finished; // decoded but not in the tile map yet
+	std::vector<std::vector<uint8_t>> spareCells; // blocks of dropped chunks, reused so streaming doesn't allocate
+	std::shared_ptr<const LevelFile> reloaded; // opened by the worker, waiting for update() to switch to it
+	bool reloadRequested = false;
+	bool stopping = false;
+
+	void work();
+	std::vector<uint8_t> takeSpareCells();
+	bool decode(const LevelFile& file, int chunk, std::vector<uint8_t>& cells) const;
+	void indexSpawns();
+	void switchLevel(GameState& gs, std::shared_ptr<const LevelFile> file);
+	void loadNow(GameState& gs, int chunk);
+	void activate(GameState& gs, const Resources& res, int chunk);
+	void removeOutsideActive(GameState& gs);
+	int chunkAt(float x) const;
+
+public:
+	LevelStreamer() = default;
+	~LevelStreamer() { close(); }
+	LevelStreamer(const LevelStreamer&) = delete;
+	LevelStreamer& operator=(const LevelStreamer&) = delete;
+
+	// maps the level and sets gs up with an empty tile map of its size and the player, then loads what is around the player
+	bool open(const std::string& levelPath, const SDLState& state, GameState& gs, const Resources& res);
+	// stops the worker and unmaps the level
+	void close();
+
+	// call once per frame after gs.mapViewport moved, loads, activates and drops chunks around it
+	void update(GameState& gs, const Resources& res);
+	// any thread: the level file changed on disk, the worker opens it again and the next update() picks up what changed
+	void reload();
+	// chunks whose tiles were dropped by the last update(), whatever was cached for them can go too
+	const std::vector<int>& evictedChunks() const { return evicted; }
+
+	// the part of streaming the simulation depends on: which chunks are active and which enemy came from which spawn
+	void capture(SnapshotWriter& out) const;
+	// makes exactly the captured chunks active again, loading them right away if they aren't. Nothing gets spawned, the
+	// characters come back with the rest of the snapshot. Returns false if the snapshot is for another level
+	bool restore(SnapshotReader& in, GameState& gs);
+
+	size_t residentCount() const { return resident.size(); }
+	size_t spawnPointCount() const { return spawned.size(); }
+	bool isOpen() const { return !states.empty(); }
+	const std::string& getPath() const { return path; }
+};
@@ -0,0 +1,106 @@
+// mappedFile.cpp : Read only memory mapped files for Windows and POSIX.
+//
+
+#include "mappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	file = handle;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		close();
+		return false;
+	}
+	bytes = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!bytes)
+	{
+		close();
+		return false;
+	}
+	length = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes)
+	{
+		UnmapViewOfFile(bytes);
+	}
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+	if (file)
+	{
+		CloseHandle(file);
+	}
+	bytes = nullptr;
+	length = 0;
+	mapping = file = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& path)
+{
+	close();
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0)
+	{
+		close();
+		return false;
+	}
+	void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	if (address == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	bytes = static_cast<const uint8_t*>(address);
+	length = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (bytes)
+	{
+		munmap(const_cast<uint8_t*>(bytes), length);
+	}
+	if (fd >= 0)
+	{
+		::close(fd);
+	}
+	bytes = nullptr;
+	length = 0;
+	fd = -1;
+}
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+NOTE: Mapping a file lets the OS page it into memory on demand instead of us copying it into a buffer first.
+The pointer can be handed straight to SDL_UpdateTexture (or read like a struct), and pages that are already in the
+file cache from the last run don't even touch the disk. The mapping is read only and lives as long as the object.
+*/
+class MappedFile
+{
+	const uint8_t* bytes = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	void* file = nullptr; // HANDLEs, kept as void* so windows.h stays out of every file that includes this
+	void* mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	const uint8_t* data() const { return bytes; }
+	size_t size() const { return length; }
+};
@@ -0,0 +1,438 @@
+// microBench.cpp : Times the per entity parts of a tick and of drawing on scenes of different sizes, and writes the results as JSON.
+//
+// usage: sdl3-bench [--scene TILES,CHARACTERS,BULLETS]... [--iterations N] [--seed N] [--out file.json]
+// run it from the folder that contains data/. Sprites are drawn with SDL's software renderer into a surface, so no window
+// or GPU is needed. Everything runs on one thread, the numbers are per call and per entity and not per tick
+
+#include "aabbBatch.h"
+#include "draw.h"
+#include "game.h"
+#include "snapshot.h"
+#include "spriteBatch.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+struct SceneSize
+{
+	int tiles; // level length in columns
+	int characters; // the player and the enemies spread over the level
+	int bullets; // bullets in flight when the measurements start
+};
+// used when no --scene is given, from a screen's worth of level to more than the game ever has
+static const SceneSize DEFAULT_SCENES[] = { { 100, 10, 10 }, { 1000, 100, 100 }, { 10000, 1000, 1000 } };
+static const int WARMUP_TICKS = 60; // bullets spread out and start hitting enemies before anything is timed
+
+struct BenchOptions
+{
+	std::vector<SceneSize> scenes;
+	int iterations = 200; // timed calls per benchmark and scene
+	unsigned seed = 1;
+	const char* out = "bench.json";
+};
+
+struct Result
+{
+	std::string name;
+	SceneSize scene;
+	size_t items; // entities (or contacts) one call works through
+	double minUs, medianUs, meanUs;
+};
+
+static bool parseArgs(int argc, char* argv[], BenchOptions& opt)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			return false;
+		}
+		if (std::strcmp(argv[i], "--out") == 0)
+		{
+			opt.out = argv[++i];
+			continue;
+		}
+		if (std::strcmp(argv[i], "--scene") == 0)
+		{
+			SceneSize scene{};
+			if (std::sscanf(argv[++i], "%d,%d,%d", &scene.tiles, &scene.characters, &scene.bullets) != 3 ||
+				scene.tiles < 0 || scene.characters < 1 || scene.bullets < 0)
+			{
+				return false;
+			}
+			opt.scenes.push_back(scene);
+			continue;
+		}
+		const long value = std::strtol(argv[i + 1], nullptr, 10);
+		if (value < 0)
+		{
+			return false;
+		}
+		if (std::strcmp(argv[i], "--iterations") == 0) opt.iterations = static_cast<int>(value);
+		else if (std::strcmp(argv[i], "--seed") == 0) opt.seed = static_cast<unsigned>(value);
+		else return false;
+		i++;
+	}
+	if (opt.scenes.empty())
+	{
+		opt.scenes.assign(std::begin(DEFAULT_SCENES), std::end(DEFAULT_SCENES));
+	}
+	return opt.iterations > 0;
+}
+
+// the same kind of level the headless benchmark makes up: flat ground, walls at both ends and random panels
+static void createScene(const SDLState& state, GameState& gs, const Resources& res, const SceneSize& size, std::mt19937& rng)
+{
+	const int cols = std::max(size.tiles, 16);
+	const float top = static_cast<float>(state.logicalHeight - MAP_ROWS * TILE_SIZE);
+	gs.tiles = TileMap(MAP_ROWS, cols, TILE_SIZE, top);
+	gs.grid.reset(gs.levelBounds());
+	setupTileTypes(gs, res);
+	for (int c = 0; c < cols; c++)
+	{
+		gs.tiles.set(TILE_LAYER_LEVEL, MAP_ROWS - 1, c, 1);
+		if (c > 0 && c < cols - 1 && rng() % 8 == 0)
+		{
+			gs.tiles.set(TILE_LAYER_LEVEL, 1 + rng() % (MAP_ROWS - 2), c, 2);
+		}
+	}
+	for (int r = 0; r < MAP_ROWS; r++)
+	{
+		gs.tiles.set(TILE_LAYER_LEVEL, r, 0, 2);
+		gs.tiles.set(TILE_LAYER_LEVEL, r, cols - 1, 2);
+	}
+
+	// everyone starts out standing on the ground, so the shots that are flying when timing starts are at enemy height
+	const float ground = top + (MAP_ROWS - 2) * TILE_SIZE;
+	spawnPlayer(gs, res, glm::vec2(2 * TILE_SIZE, ground));
+	const int enemies = size.characters - 1;
+	for (int i = 0; i < enemies; i++)
+	{
+		const int c = 2 + static_cast<int>(static_cast<long long>(i) * (cols - 4) / std::max(enemies, 1));
+		Entity e = spawnEnemy(gs, res, glm::vec2(c * TILE_SIZE, ground));
+		gs.characters.physics[gs.characters.indexOf(e)].velocity.x = rng() % 2 ? 50.0f : -50.0f;
+	}
+}
+
+static void topUpBullets(GameState& gs, const Resources& res, const SceneSize& size, std::mt19937& rng)
+{
+	for (int attempt = 0; gs.bullets.size() < static_cast<size_t>(size.bullets) && attempt < 4 * size.bullets; attempt++)
+	{
+		// shots fired in mid-air fly over the enemies' heads, only characters on the ground shoot
+		const size_t shooter = rng() % gs.characters.size();
+		if (!gs.characters.physics[shooter].grounded)
+		{
+			continue;
+		}
+		const float direction = rng() % 2 ? 1.0f : -1.0f;
+		// in front of the shooter, a bullet that starts inside an enemy hits it right away
+		const glm::vec2 position = gs.characters.transform[shooter].position + glm::vec2(TILE_SIZE / 2 + direction * TILE_SIZE, TILE_SIZE / 2);
+		if (!gs.bullets.isValid(spawnBullet(gs, res, position, glm::vec2(600.0f * direction, 0), direction)))
+		{
+			break;
+		}
+	}
+}
+
+// the collision passes need the ones before them to have run, benchmarks get the tick up to where they start with this.
+// Same order as simulate(), on this thread
+enum class Stage { update, resolveCharacters, resolveBullets, findContacts, applyContacts };
+static void runUntil(const SDLState& state, GameState& gs, Resources& res, Stage stage)
+{
+	WorkerScratch& scratch = gs.scratch[0];
+	scratch.contacts.clear(); // whatever the last findContacts call left behind
+	savePreviousPositions(gs.characters);
+	savePreviousPositions(gs.bullets);
+	if (stage == Stage::update)
+	{
+		return;
+	}
+	for (size_t i = 0; i < gs.characters.size(); i++)
+	{
+		update(state, gs, res, gs.characters, i, TICK_TIME);
+	}
+	for (size_t i = 0; i < gs.bullets.size(); i++)
+	{
+		update(state, gs, res, gs.bullets, i, TICK_TIME);
+	}
+	if (stage == Stage::resolveCharacters)
+	{
+		return;
+	}
+	for (size_t i = 0; i < gs.characters.size(); i++)
+	{
+		resolveLevel(state, gs, res, gs.characters, i, scratch, TICK_TIME);
+	}
+	for (size_t i = 0; i < gs.characters.size(); i++)
+	{
+		gs.grid.move(GameState::colliderId(gs.characters.entityAt(i)), gs.characters.worldCollider(i));
+	}
+	if (stage == Stage::resolveBullets)
+	{
+		return;
+	}
+	for (size_t i = 0; i < gs.bullets.size(); i++)
+	{
+		if (gs.bullets.data[i].bullet.state == BulletState::moving)
+		{
+			resolveLevel(state, gs, res, gs.bullets, i, scratch, TICK_TIME);
+		}
+	}
+	if (stage == Stage::findContacts)
+	{
+		return;
+	}
+	for (size_t i = 0; i < gs.characters.size(); i++)
+	{
+		findContacts(gs, gs.characters, i, scratch);
+	}
+	for (size_t i = 0; i < gs.bullets.size(); i++)
+	{
+		if (gs.bullets.data[i].bullet.state == BulletState::moving)
+		{
+			findContacts(gs, gs.bullets, i, scratch);
+		}
+	}
+}
+
+// puts the scene back into the snapshot before every call, so each one sees the same state and nothing piles up over
+// the iterations. Neither that nor prepare() is part of the time
+static Result measure(const char* name, const SceneSize& scene, size_t items, int iterations, GameState& gs, LevelStreamer& level,
+	const Snapshot& start, const std::function<void()>& prepare, const std::function<void()>& run)
+{
+	const double counterFrequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	std::vector<double> times;
+	times.reserve(iterations);
+	for (int i = 0; i < iterations; i++)
+	{
+		start.restore(gs, level);
+		if (prepare)
+		{
+			prepare();
+		}
+		const uint64_t begin = SDL_GetPerformanceCounter();
+		run();
+		times.push_back((SDL_GetPerformanceCounter() - begin) / counterFrequency * 1e6);
+	}
+	start.restore(gs, level);
+
+	double total = 0;
+	for (double t : times)
+	{
+		total += t;
+	}
+	std::sort(times.begin(), times.end());
+	return Result{ name, scene, items, times.front(), times[times.size() / 2], total / times.size() };
+}
+
+static void benchScene(SDLState& state, Resources& res, SpriteBatch& batch, const SceneSize& size, const BenchOptions& opt,
+	std::vector<Result>& results)
+{
+	std::mt19937 rng(opt.seed);
+	GameState gs(state, std::max(size.bullets, 1));
+	gs.scratch.resize(1);
+	createScene(state, gs, res, size, rng);
+	LevelStreamer level; // never opened, the scene is made up and fully loaded
+	for (int tick = 0; tick < WARMUP_TICKS; tick++)
+	{
+		simulate(state, gs, res, TICK_TIME);
+		topUpBullets(gs, res, size, rng);
+	}
+	Snapshot start;
+	start.capture(gs, level, 0);
+
+	const size_t characters = gs.characters.size();
+	const size_t bullets = gs.bullets.size();
+	const SceneSize scene{ gs.tiles.getCols(), static_cast<int>(characters), static_cast<int>(bullets) };
+	const int n = opt.iterations;
+	auto prepareFor = [&](Stage stage) { return [&state, &gs, &res, stage]() { runUntil(state, gs, res, stage); }; };
+
+	results.push_back(measure("update characters", scene, characters, n, gs, level, start, prepareFor(Stage::update), [&]()
+		{
+			for (size_t i = 0; i < gs.characters.size(); i++)
+			{
+				update(state, gs, res, gs.characters, i, TICK_TIME);
+			}
+		}));
+	results.push_back(measure("update bullets", scene, bullets, n, gs, level, start, prepareFor(Stage::update), [&]()
+		{
+			for (size_t i = 0; i < gs.bullets.size(); i++)
+			{
+				update(state, gs, res, gs.bullets, i, TICK_TIME);
+			}
+		}));
+	results.push_back(measure("resolveLevel characters", scene, characters, n, gs, level, start, prepareFor(Stage::resolveCharacters), [&]()
+		{
+			for (size_t i = 0; i < gs.characters.size(); i++)
+			{
+				resolveLevel(state, gs, res, gs.characters, i, gs.scratch[0], TICK_TIME);
+			}
+		}));
+	results.push_back(measure("resolveLevel bullets", scene, bullets, n, gs, level, start, prepareFor(Stage::resolveBullets), [&]()
+		{
+			for (size_t i = 0; i < gs.bullets.size(); i++)
+			{
+				if (gs.bullets.data[i].bullet.state == BulletState::moving)
+				{
+					resolveLevel(state, gs, res, gs.bullets, i, gs.scratch[0], TICK_TIME);
+				}
+			}
+		}));
+	results.push_back(measure("findContacts", scene, characters + bullets, n, gs, level, start, prepareFor(Stage::findContacts), [&]()
+		{
+			for (size_t i = 0; i < gs.characters.size(); i++)
+			{
+				findContacts(gs, gs.characters, i, gs.scratch[0]);
+			}
+			for (size_t i = 0; i < gs.bullets.size(); i++)
+			{
+				if (gs.bullets.data[i].bullet.state == BulletState::moving)
+				{
+					findContacts(gs, gs.bullets, i, gs.scratch[0]);
+				}
+			}
+		}));
+	// applyContacts() runs checkCollision() once per contact (bullets hitting enemies), so that is what it is counted per
+	start.restore(gs, level);
+	runUntil(state, gs, res, Stage::applyContacts);
+	const size_t contacts = gs.scratch[0].contacts.size();
+	gs.scratch[0].contacts.clear();
+	results.push_back(measure("checkCollision", scene, contacts, n, gs, level, start, prepareFor(Stage::applyContacts), [&]()
+		{
+			applyContacts(state, gs, res, TICK_TIME);
+		}));
+
+	results.push_back(measure("AnimationState::step", scene, characters + bullets, n, gs, level, start, nullptr, [&]()
+		{
+			stepAnimations(gs.characters, res, TICK_TIME);
+			stepAnimations(gs.bullets, res, TICK_TIME);
+		}));
+	volatile float frameSink = 0; // keeps the frame lookups from being optimized away
+	results.push_back(measure("AnimationClip::frameAt", scene, characters + bullets, n, gs, level, start, nullptr, [&]()
+		{
+			float sum = 0;
+			for (EntityStore* store : { &gs.characters, &gs.bullets })
+			{
+				for (size_t i = 0; i < store->size(); i++)
+				{
+					const AnimationState& anim = store->animation[i];
+					if (anim.clip != -1)
+					{
+						sum += res.clips[anim.clip].frameAt(anim.time).x;
+					}
+				}
+			}
+			frameSink = sum;
+		}));
+
+	// every entity gets drawn, not only what is near the camera like in the game, so the work grows with the scene.
+	// Sprites off screen still cost a quad each, the renderer throws them away when it clips
+	auto queueAll = [&]()
+		{
+			for (size_t i = 0; i < gs.characters.size(); i++)
+			{
+				drawObject(state, gs, res, batch, gs.characters, i, TILE_SIZE, TILE_SIZE, 0.5f);
+			}
+			for (size_t i = 0; i < gs.bullets.size(); i++)
+			{
+				drawObject(state, gs, res, batch, gs.bullets, i, gs.bullets.collider[i].w, gs.bullets.collider[i].h, 0.5f);
+			}
+		};
+	results.push_back(measure("drawObject", scene, characters + bullets, n, gs, level, start, [&]() { batch.clear(); }, queueAll));
+	batch.clear();
+	if (state.renderer)
+	{
+		results.push_back(measure("SpriteBatch::flush", scene, characters + bullets, n, gs, level, start, [&]()
+			{
+				batch.clear();
+				queueAll();
+			}, [&]()
+			{
+				batch.flush(state.renderer);
+			}));
+	}
+	batch.clear();
+}
+
+static bool writeJson(const char* path, const BenchOptions& opt, bool rendered, const std::vector<Result>& results)
+{
+	FILE* file = std::fopen(path, "w");
+	if (!file)
+	{
+		return false;
+	}
+	std::fprintf(file, "{\n\t\"iterations\": %d,\n\t\"seed\": %u,\n\t\"box_tests\": \"%s\",\n\t\"renderer\": \"%s\",\n\t\"results\": [\n",
+		opt.iterations, opt.seed, AabbBatch::KERNEL, rendered ? "software" : "none");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result& r = results[i];
+		const double nsPerItem = r.items ? r.medianUs * 1000.0 / r.items : 0.0;
+		std::fprintf(file, "\t\t{ \"name\": \"%s\", \"tiles\": %d, \"characters\": %d, \"bullets\": %d, \"items\": %zu, "
+			"\"min_us\": %.3f, \"median_us\": %.3f, \"mean_us\": %.3f, \"ns_per_item\": %.2f }%s\n",
+			r.name.c_str(), r.scene.tiles, r.scene.characters, r.scene.bullets, r.items, r.minUs, r.medianUs, r.meanUs, nsPerItem,
+			i + 1 < results.size() ? "," : "");
+	}
+	std::fprintf(file, "\t]\n}\n");
+	return std::fclose(file) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions opt;
+	if (!parseArgs(argc, argv, opt))
+	{
+		std::fprintf(stderr, "usage: %s [--scene TILES,CHARACTERS,BULLETS]... [--iterations N] [--seed N] [--out file.json]\n", argv[0]);
+		return 1;
+	}
+
+	// no window, the software renderer draws into a surface the size of the game's logical resolution
+	bool keys[SDL_SCANCODE_COUNT] = {};
+	SDLState state;
+	state.window = nullptr;
+	state.width = state.logicalWidth = 640;
+	state.height = state.logicalHeight = 320;
+	state.keys = keys;
+	SDL_Surface* target = SDL_CreateSurface(state.logicalWidth, state.logicalHeight, SDL_PIXELFORMAT_RGBA32);
+	state.renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+	if (!state.renderer)
+	{
+		std::fprintf(stderr, "no software renderer (%s), SpriteBatch::flush won't be timed\n", SDL_GetError());
+	}
+
+	Resources res;
+	res.load(state);
+	jobs().start(1); // warming up goes through simulate(), the timed parts are called directly
+	SpriteBatch batch;
+
+	std::vector<Result> results;
+	for (const SceneSize& size : opt.scenes)
+	{
+		benchScene(state, res, batch, size, opt, results);
+	}
+
+	std::printf("%-24s %8s %8s %8s %10s %12s %12s\n", "", "tiles", "chars", "bullets", "items", "median us", "ns/item");
+	for (const Result& r : results)
+	{
+		std::printf("%-24s %8d %8d %8d %10zu %12.2f %12.2f\n", r.name.c_str(), r.scene.tiles, r.scene.characters, r.scene.bullets,
+			r.items, r.medianUs, r.items ? r.medianUs * 1000.0 / r.items : 0.0);
+	}
+	const bool written = writeJson(opt.out, opt, state.renderer != nullptr, results);
+	if (!written)
+	{
+		std::fprintf(stderr, "could not write %s\n", opt.out);
+	}
+
+	jobs().stop();
+	res.unload();
+	if (state.renderer)
+	{
+		SDL_DestroyRenderer(state.renderer);
+	}
+	SDL_DestroySurface(target);
+	return written ? 0 : 1;
+}
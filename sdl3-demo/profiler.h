@@ -0,0 +1,241 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/*
+NOTE: PROFILE_ZONE("name") at the top of a block measures how long the block takes. Each zone only reads the performance
+counter twice and writes one event into a fixed size ring buffer, so it is cheap enough to leave on all the time.
+The ring never allocates or locks: writers grab a slot with an atomic counter and the oldest events simply get overwritten.
+Once per frame endFrame() sums up what each zone cost for the overlay, and writeChromeTrace() dumps whatever is still in
+the ring to a file that chrome://tracing or ui.perfetto.dev can open.
+*/
+struct ProfileEvent
+{
+	const char* name; // only the pointer is stored, so zone names have to be string literals
+	uint64_t start, end; // performance counter ticks
+	uint32_t thread;
+};
+
+class Profiler
+{
+public:
+	static const size_t CAPACITY = 1 << 16; // power of two so finding a slot is just a mask
+	static const size_t HISTORY = 120; // frames the overlay averages over
+
+private:
+	// the fields are relaxed atomics rather than a ProfileEvent, a reader can look at a slot while a writer fills it in.
+	// sequence tells whether what it read belongs together
+	struct Slot
+	{
+		std::atomic<uint64_t> sequence{ 0 }; // index + 1 of the event stored here, 0 while it is being written
+		std::atomic<const char*> name{ nullptr };
+		std::atomic<uint64_t> start{ 0 }, end{ 0 };
+		std::atomic<uint32_t> thread{ 0 };
+	};
+	struct Phase
+	{
+		const char* name;
+		double frameTotal; // ms spent in this zone during the frame being collected
+		std::array<double, HISTORY> history; // ms per frame for the last HISTORY frames
+	};
+
+	std::unique_ptr<Slot[]> slots;
+	std::atomic<uint64_t> writeIndex{ 0 };
+	std::atomic<uint32_t> nextThread{ 0 };
+	uint64_t readIndex = 0; // events before this were already counted by endFrame
+	std::vector<Phase> phases;
+	size_t frame = 0;
+	double msPerTick;
+
+	uint32_t threadId()
+	{
+		thread_local uint32_t id = nextThread.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+	// copies the event at index, false if it was overwritten or is still being written
+	bool read(uint64_t index, ProfileEvent& out) const
+	{
+		const Slot& slot = slots[index & (CAPACITY - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+		{
+			return false;
+		}
+		out.name = slot.name.load(std::memory_order_relaxed);
+		out.start = slot.start.load(std::memory_order_relaxed);
+		out.end = slot.end.load(std::memory_order_relaxed);
+		out.thread = slot.thread.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+	}
+	uint64_t oldestIndex(uint64_t end) const { return end > CAPACITY ? end - CAPACITY : 0; }
+	Phase& phase(const char* name)
+	{
+		for (Phase& p : phases)
+		{
+			if (p.name == name || std::strcmp(p.name, name) == 0)
+			{
+				return p;
+			}
+		}
+		phases.push_back(Phase{ name, 0, {} });
+		return phases.back();
+	}
+
+public:
+	Profiler() : slots(new Slot[CAPACITY]), msPerTick(1000.0 / SDL_GetPerformanceFrequency())
+	{
+	}
+
+	void record(const char* name, uint64_t start, uint64_t end)
+	{
+		const uint64_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+		Slot& slot = slots[index & (CAPACITY - 1)];
+		slot.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(name, std::memory_order_relaxed);
+		slot.start.store(start, std::memory_order_relaxed);
+		slot.end.store(end, std::memory_order_relaxed);
+		slot.thread.store(threadId(), std::memory_order_relaxed);
+		slot.sequence.store(index + 1, std::memory_order_release);
+	}
+
+	// adds up the time of every zone that closed since the last call, call it once per frame from the main thread.
+	// Zones count towards the frame whose endFrame() first sees them finished, whichever thread they ran on. The simulation
+	// thread's zones for the list being drawn mostly land in this frame, the ones still open land in the next
+	void endFrame()
+	{
+		for (Phase& p : phases)
+		{
+			p.frameTotal = 0;
+		}
+		const uint64_t end = writeIndex.load(std::memory_order_acquire);
+		ProfileEvent event;
+		uint64_t i = std::max(readIndex, oldestIndex(end));
+		for (; i < end; i++)
+		{
+			if (read(i, event))
+			{
+				phase(event.name).frameTotal += (event.end - event.start) * msPerTick;
+			}
+			else if (i >= oldestIndex(writeIndex.load(std::memory_order_acquire)))
+			{
+				break; // another thread claimed the slot and is still writing it, the next frame picks it up
+			}
+		}
+		readIndex = i;
+		for (Phase& p : phases)
+		{
+			p.history[frame % HISTORY] = p.frameTotal;
+		}
+		frame++;
+	}
+
+	// rolling per zone timings, one line per zone in the order they were first seen
+	void drawOverlay(SDL_Renderer* renderer, float x, float y) const
+	{
+		const size_t frames = std::min(frame, HISTORY);
+		if (frames == 0)
+		{
+			return;
+		}
+		const float lineHeight = 10;
+		SDL_FRect background{
+			.x = x - 4,
+			.y = y - 4,
+			.w = 41 * 8 + 8,
+			.h = (phases.size() + 1) * lineHeight + 6
+		};
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+		SDL_RenderFillRect(renderer, &background);
+		SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+
+		char line[64];
+		std::snprintf(line, sizeof(line), "%-16s %9s %9s", "zone", "avg ms", "max ms");
+		SDL_RenderDebugText(renderer, x, y, line);
+		for (size_t p = 0; p < phases.size(); p++)
+		{
+			double total = 0, peak = 0;
+			for (size_t f = 0; f < frames; f++)
+			{
+				total += phases[p].history[f];
+				peak = std::max(peak, phases[p].history[f]);
+			}
+			std::snprintf(line, sizeof(line), "%-16.16s %9.3f %9.3f", phases[p].name, total / frames, peak);
+			SDL_RenderDebugText(renderer, x, y + (p + 1) * lineHeight, line);
+		}
+	}
+
+	// writes every event still in the ring as Chrome trace event JSON
+	bool writeChromeTrace(const char* path) const
+	{
+		std::FILE* file = std::fopen(path, "w");
+		if (!file)
+		{
+			return false;
+		}
+		const uint64_t end = writeIndex.load(std::memory_order_acquire);
+		std::vector<ProfileEvent> events;
+		events.reserve(end - oldestIndex(end));
+		ProfileEvent event;
+		uint64_t base = UINT64_MAX;
+		for (uint64_t i = oldestIndex(end); i < end; i++)
+		{
+			if (read(i, event))
+			{
+				events.push_back(event);
+				base = std::min(base, event.start);
+			}
+		}
+
+		const double usPerTick = msPerTick * 1000.0;
+		std::fputs("{\"traceEvents\":[\n", file);
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			const ProfileEvent& e = events[i];
+			std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+				e.name, e.thread, (e.start - base) * usPerTick, (e.end - e.start) * usPerTick,
+				i + 1 < events.size() ? "," : "");
+		}
+		std::fputs("],\"displayTimeUnit\":\"ms\"}\n", file);
+		return std::fclose(file) == 0;
+	}
+};
+
+inline Profiler& profiler()
+{
+	static Profiler instance;
+	return instance;
+}
+
+class ProfileZone
+{
+	const char* name;
+	uint64_t start;
+public:
+	ProfileZone(const char* name) : name(name), start(SDL_GetPerformanceCounter())
+	{
+	}
+	~ProfileZone()
+	{
+		profiler().record(name, start, SDL_GetPerformanceCounter());
+	}
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+// compile with PROFILER_DISABLED to strip every zone out of the build
+#ifdef PROFILER_DISABLED
+#define PROFILE_ZONE(name)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#endif
@@ -0,0 +1,289 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "spriteBatch.h"
+#include "tileMap.h"
+
+/*
+NOTE: Simulating, queueing sprites and SDL_RenderPresent used to run one after the other on the main thread, so every ms
+the driver or VSync held us up was a ms the simulation sat idle. Now the simulation runs on a thread of its own and
+describes each frame in a DrawList: the camera, the background layers, the tile chunks that changed, the sprite quads
+and the debug text. Once it is published nobody writes to a list any more. The main thread draws and presents the
+previous frame's list while the simulation works on the next one. Two lists are enough for that. The simulation waits
+until the main thread has picked up the last list it published, so it is never more than one frame ahead and no list
+(and none of the tile changes in it) is ever skipped.
+The renderer stays on the main thread because SDL wants rendering and event handling there. Drawing never looks at
+GameState, the main thread keeps its own TileMirror of the tile map for the tile caches, built from the chunk copies in
+the lists.
+*/
+
+// one chunk of the tile map the way the simulation had it when the list was built
+struct TileChunkCopy
+{
+	int chunk;
+	std::vector<uint8_t> cells; // TileMap::chunkCellCount() bytes, empty if the chunk isn't loaded
+};
+
+// a background picture repeated along x, starting at x
+struct ParallaxLayer
+{
+	AtlasRegion sprite;
+	float x;
+};
+
+struct DrawList
+{
+	SDL_FRect visibleArea{}; // world space
+	float cameraX = 0;
+
+	AtlasRegion sky; // stretched over the whole screen behind everything
+	std::vector<ParallaxLayer> parallax; // back to front
+
+	// layout and tile types of the map, and the chunks near the camera that changed since the last list
+	int tileRows = 0, tileCols = 0;
+	float tileSize = 0, tileOriginY = 0;
+	std::vector<TileType> tileTypes;
+	std::vector<TileChunkCopy> tileChunks; // only the first tileChunkCount are part of this list, the rest keep their memory
+	size_t tileChunkCount = 0;
+	std::vector<int> evictedChunks; // chunks the level streamer dropped, their cached textures can go
+
+	// sprites with their screen positions worked out, drawn after the level tiles and before the foreground tiles
+	SpriteBatch characters, bullets;
+	std::string debugText;
+
+	// empties the list for the next frame, everything keeps its memory
+	void clear()
+	{
+		parallax.clear();
+		tileChunkCount = 0;
+		evictedChunks.clear();
+		characters.clear();
+		bullets.clear();
+		debugText.clear();
+	}
+	TileChunkCopy& addTileChunk()
+	{
+		if (tileChunkCount == tileChunks.size())
+		{
+			tileChunks.emplace_back();
+		}
+		return tileChunks[tileChunkCount++];
+	}
+};
+
+// simulation side: remembers the chunk revisions the main thread already got, so a list only copies what changed
+class TileSync
+{
+	std::vector<std::array<uint32_t, TILE_LAYER_COUNT>> sent; // revision per layer of every chunk, 0 = never sent
+	int rows = 0, cols = 0;
+	float tileSize = 0, originY = 0;
+
+public:
+	// writes the layout and types of tiles into list, and a copy of every chunk under list.visibleArea that changed
+	void write(const TileMap& tiles, DrawList& list)
+	{
+		if (tiles.getRows() != rows || tiles.getCols() != cols || tiles.getTileSize() != tileSize || tiles.getOriginY() != originY)
+		{
+			// another map, the main thread starts over with an empty mirror
+			rows = tiles.getRows();
+			cols = tiles.getCols();
+			tileSize = tiles.getTileSize();
+			originY = tiles.getOriginY();
+			sent.assign(tiles.chunkCount(), {});
+		}
+		list.tileRows = rows;
+		list.tileCols = cols;
+		list.tileSize = tileSize;
+		list.tileOriginY = originY;
+		list.tileTypes.clear();
+		for (size_t id = 0; id < tiles.typeCount(); id++)
+		{
+			list.tileTypes.push_back(tiles.type(static_cast<uint8_t>(id)));
+		}
+
+		int first, last;
+		tiles.chunkRange(list.visibleArea, first, last);
+		for (int chunk = first; chunk <= last; chunk++)
+		{
+			bool changed = false;
+			for (size_t layer = 0; layer < TILE_LAYER_COUNT; layer++)
+			{
+				changed |= sent[chunk][layer] != tiles.chunkRevision(layer, chunk);
+				sent[chunk][layer] = tiles.chunkRevision(layer, chunk);
+			}
+			if (changed)
+			{
+				TileChunkCopy& copy = list.addTileChunk();
+				copy.chunk = chunk;
+				copy.cells = tiles.chunkCells(chunk);
+			}
+		}
+	}
+};
+
+// main thread side: the tile map as far as the lists told us about it, only chunks that were near the camera are filled in
+class TileMirror
+{
+	TileMap tiles;
+	std::vector<uint8_t> cells; // swapped in and out of tiles so applying a chunk doesn't allocate
+
+	static bool sameType(const TileType& a, const TileType& b)
+	{
+		return a.solid == b.solid && a.sprite.texture == b.sprite.texture && a.sprite.area.x == b.sprite.area.x &&
+			a.sprite.area.y == b.sprite.area.y && a.sprite.area.w == b.sprite.area.w && a.sprite.area.h == b.sprite.area.h;
+	}
+
+public:
+	// brings the mirror up to date with list, chunks that change get a new revision so the tile caches bake them again
+	void apply(const DrawList& list)
+	{
+		if (list.tileRows != tiles.getRows() || list.tileCols != tiles.getCols() || list.tileSize != tiles.getTileSize() ||
+			list.tileOriginY != tiles.getOriginY())
+		{
+			tiles = TileMap(list.tileRows, list.tileCols, list.tileSize, list.tileOriginY, false);
+		}
+		for (size_t id = 1; id < list.tileTypes.size(); id++)
+		{
+			if (id >= tiles.typeCount() || !sameType(tiles.type(static_cast<uint8_t>(id)), list.tileTypes[id]))
+			{
+				tiles.setType(static_cast<uint8_t>(id), list.tileTypes[id]);
+			}
+		}
+		for (int chunk : list.evictedChunks)
+		{
+			if (chunk < tiles.chunkCount())
+			{
+				tiles.unloadChunk(chunk, cells);
+			}
+		}
+		for (size_t i = 0; i < list.tileChunkCount; i++)
+		{
+			const TileChunkCopy& copy = list.tileChunks[i];
+			cells = copy.cells;
+			tiles.loadChunk(copy.chunk, cells);
+		}
+	}
+
+	const TileMap& get() const { return tiles; }
+};
+
+// the two DrawLists, handed back and forth between the simulation and the main thread
+class DrawListQueue
+{
+	std::array<DrawList, 2> lists;
+	std::mutex mutex;
+	std::condition_variable changed;
+	int writing = -1; // being filled by the simulation
+	int ready = -1; // published and not picked up yet
+	int reading = -1; // being drawn
+	bool closed = false;
+	std::atomic<size_t> drawCalls{ 0 }; // SDL_RenderGeometry calls of the last frame drawn, for the debug text
+
+public:
+	// simulation thread: an empty list to describe the next frame in. Waits until the main thread has picked up the last
+	// one, returns nullptr once close() was called
+	DrawList* beginWrite()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [this]() { return closed || ready == -1; });
+		if (closed)
+		{
+			return nullptr;
+		}
+		writing = reading == 0 ? 1 : 0;
+		DrawList& list = lists[writing];
+		lock.unlock();
+		list.clear();
+		return &list;
+	}
+	// simulation thread: hands the list from beginWrite() to the main thread
+	void publish()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			ready = writing;
+			writing = -1;
+		}
+		changed.notify_all();
+	}
+
+	// main thread: the next published list, nullptr if none came within timeoutMs. The list returned by the previous call
+	// goes back to the simulation
+	const DrawList* acquire(uint32_t timeoutMs)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]() { return closed || ready != -1; }) || ready == -1)
+		{
+			return nullptr;
+		}
+		reading = ready;
+		ready = -1;
+		lock.unlock();
+		changed.notify_all();
+		return &lists[reading];
+	}
+
+	// wakes up and stops the simulation thread, beginWrite() returns nullptr from now on
+	void close()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			closed = true;
+		}
+		changed.notify_all();
+	}
+
+	void setDrawCalls(size_t count) { drawCalls.store(count, std::memory_order_relaxed); }
+	size_t getDrawCalls() const { return drawCalls.load(std::memory_order_relaxed); }
+};
+
+// key presses, the keyboard state and whatever else the main thread (which has to pump the events) learns about that
+// is up to the simulation
+class InputInbox
+{
+	std::mutex mutex;
+	std::vector<SDL_KeyboardEvent> events;
+	std::array<bool, SDL_SCANCODE_COUNT> keys{};
+	bool levelChanged = false;
+
+public:
+	void push(const SDL_KeyboardEvent& key)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		events.push_back(key);
+	}
+	// keyboard as of the last event that was pumped
+	void setKeys(const bool* state)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		std::copy(state, state + SDL_SCANCODE_COUNT, keys.begin());
+	}
+	// moves the events pushed since the last call into out, which should be empty, and copies the keyboard into keysOut
+	void take(std::vector<SDL_KeyboardEvent>& out, bool* keysOut)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		out.swap(events);
+		std::copy(keys.begin(), keys.end(), keysOut);
+	}
+	// the level file changed on disk, the simulation decides whether it gets reloaded
+	void pushLevelChanged()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		levelChanged = true;
+	}
+	// true once after pushLevelChanged() was called
+	bool takeLevelChanged()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return std::exchange(levelChanged, false);
+	}
+};
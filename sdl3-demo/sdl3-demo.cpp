@@ -1,4 +1,4 @@
-﻿// sdl-demo.cpp : Defines he entry point for the application.
+// sdl-demo.cpp : Defines he entry point for the application.
 //
 
 #include <SDL3/SDL.h>
@@ -6,152 +6,325 @@
 //init some setup and then recall our main to start program
 #include <SDL3/SDL_main.h>
 #include <SDL3_image/SDL_image.h>
-#include "gameObject.h"
+#include "allocationCounter.h"
+#include "draw.h"
+#include "fileWatcher.h"
+#include "frameArena.h"
+#include "game.h"
+#include "inputRecording.h"
+#include "renderPipeline.h"
+#include "snapshot.h"
+#include "spriteBatch.h"
+#include "tileLayerCache.h"
+#include <algorithm>
 #include <array>
 #include <vector>
 #include <string>
+#include <cstring>
 #include <format>
+#include <iterator>
+#include <thread>
 using namespace std;
 
-//hold important SDL objects in state to make cleanup and init more efficient by just passing through single SDL state object instead of passing SDL objects to SDL state
-struct SDLState
-{
-	SDL_Window* window;
-	SDL_Renderer* renderer;
-	int width, height, logicalWidth, logicalHeight;
-	const bool* keys;
+bool initialize(SDLState& state);
+void cleanup(SDLState& state);
+bool drawLoadingScreen(SDLState& state, Resources& res);
 
-	SDLState() : keys(SDL_GetKeyboardState(nullptr))
+// usage: sdl3-demo [--record file.inp | --replay file.inp]
+int main(int argc, char* argv[])
+{
+	const char* recordPath = nullptr; // write the input of this session here
+	const char* replayPath = nullptr; // play this recording instead of reading the keyboard
+	for (int i = 1; i + 1 < argc; i += 2)
 	{
+		if (std::strcmp(argv[i], "--record") == 0) recordPath = argv[i + 1];
+		else if (std::strcmp(argv[i], "--replay") == 0) replayPath = argv[i + 1];
 	}
-};
 
+	SDLState state;
+	state.width = 1600;
+	state.height = 900;
+	state.logicalWidth = 640;
+	state.logicalHeight = 320;
 
-const size_t LAYER_IDX_LEVEL = 0;
-const size_t LAYER_IDX_CHARACTERS = 1;
-const int MAP_ROWS = 5;
-const int MAP_COLS = 50;
-const int TILE_SIZE = 32;
-
-struct GameState
-{
-	std::array<std::vector<GameObject>, 2> layers;
-	std::vector<GameObject> backgroundTiles;
-	std::vector<GameObject> foregroundTiles;
-	std::vector<GameObject> bullets;
+	if (!initialize(state))
+	{
+		return 1;
+	}
 
-	int playerIndex;
-	SDL_FRect mapViewport;
-	float bg2Scroll, bg3Scroll, bg4Scroll;
 
-	GameState(const SDLState& state)
+	// load game assets
+	//SDL texture: piece of memory holding picture on the graphics card
+	Resources res;
+	res.beginLoad(state);
+	if (!drawLoadingScreen(state, res))
 	{
-		playerIndex = -1;
-		mapViewport = SDL_FRect{
-			.x = 0,
-			.y = 0,
-			.w = static_cast<float>(state.logicalWidth),
-			.h = static_cast<float>(state.logicalHeight)
-		};
-		bg2Scroll = bg3Scroll = bg4Scroll = 0;
+		// closed while loading
+		res.unload();
+		cleanup(state);
+		return 0;
 	}
-	GameObject& player() { return layers[LAYER_IDX_CHARACTERS][playerIndex]; }
-};
-struct Resources
-{
-	const int ANIM_PLAYER_IDLE = 0;
-	const int ANIM_PLAYER_RUN = 1;
-	const int ANIM_PLAYER_JUMP = 2;
-	const int ANIM_PLAYER_SLIDE = 3;
-	std::vector<Animation> playerAnims;
-	const int ANIM_BULLET_MOVING = 0;
-	const int ANIM_BULLET_HIT = 1;
-	std::vector<Animation> bulletAnims;
-
-	std::vector<SDL_Texture*> textures;
-	SDL_Texture* texIdle, * texRun, * texJump, * texSlide, * texBrick, * texGrass, * texGround, * texPanel,
-		* texBg1, * texBg2, * texBg3, * texBg4, * texBg5, * texBg6, * texBg7, * texBg8, * texBg9, * texBullet, * texBulletHit;
-	SDL_Texture* loadTexture(SDL_Renderer* renderer, const std::string& filepath)
+
+	// a replay brings its own level and bullet pool size, the session has to start out exactly like the recorded one
+	InputReplay replay;
+	InputRecorder recorder;
+	if (replayPath && (!replay.open(replayPath) || !replay.matches(state)))
 	{
-		SDL_Texture* tex = IMG_LoadTexture(renderer, filepath.c_str());
-		SDL_SetTextureScaleMode(tex, SDL_SCALEMODE_NEAREST); //changes from linear scaling to nearest neighbour scaling on sprite for better quality
-		textures.push_back(tex);
-		return tex;
+		SDL_Log("Can't replay %s, playing normally", replayPath);
+		replay.close();
 	}
+	const std::string levelPath = replay.isOpen() ? replay.getLevelPath() : DEFAULT_LEVEL;
 
-	void load(SDLState& state)
+	// setup game data
+	jobs().start(); // one thread per core for the parallel parts of the simulation
+	GameState gs(state, replay.isOpen() ? replay.getMaxBullets() : MAX_BULLETS);
+	LevelStreamer level; // only the chunks around the camera are kept loaded
+	if (!level.open(levelPath, state, gs, res))
 	{
-		playerAnims.resize(5);
-		playerAnims[ANIM_PLAYER_IDLE] = Animation(2, 1.6f, 0, 1);
-		playerAnims[ANIM_PLAYER_RUN] = Animation(8, 1.6f, 0, 3);
-		playerAnims[ANIM_PLAYER_JUMP] = Animation(8, 1.6f, 0, 5);
-		playerAnims[ANIM_PLAYER_SLIDE] = Animation(2, 1.0f, 0, 1);
-		bulletAnims.resize(2);
-		bulletAnims[ANIM_BULLET_MOVING] = Animation(4, 0.05f, 0, 0);
-		bulletAnims[ANIM_BULLET_HIT] = Animation(4, 0.15f, 0, 0);
-		texIdle = loadTexture(state.renderer, "data/spriteHood.png");
-		texRun = texIdle; //anim in the same file
-		texJump = texIdle;
-		texSlide = texIdle;
-		texBrick = loadTexture(state.renderer, "data/PixelTexturePack/Textures/Bricks/REDBRICKS.png");
-		texGrass = loadTexture(state.renderer, "data/PixelTexturePack/grass.png");
-		texGround = loadTexture(state.renderer, "data/PixelTexturePack/Textures/Rocks/FLATSTONES.png");
-		texPanel = loadTexture(state.renderer, "data/PixelTexturePack/Textures/Tech/BIGSQUARES.png");
-		texBullet = loadTexture(state.renderer, "data/bulletDemo.png");
-		texBulletHit = loadTexture(state.renderer, "data/bullet_hitDemo.png");
-		texBg1 = loadTexture(state.renderer, "data/nature_4/1.png");
-		texBg2 = loadTexture(state.renderer, "data/nature_4/2.png");
-		texBg3 = loadTexture(state.renderer, "data/nature_4/3.png");
-		texBg4 = loadTexture(state.renderer, "data/nature_4/4.png");
-
-
+		res.unload();
+		cleanup(state);
+		return 1;
 	}
-
-	void unload()
+	if (recordPath && !replay.isOpen())
 	{
-		for (SDL_Texture* tex : textures)
+		recorder.open(recordPath, state, levelPath, MAX_BULLETS);
+	}
+
+	// a snapshot after every tick, Backspace steps back through them and Page Up jumps back a second. The future is thrown
+	// away once the game goes on from there. Recordings only know how to play forward, so both are off while one is running
+	SnapshotRing history(static_cast<size_t>(REWIND_SECONDS * TICK_RATE));
+	uint64_t tick = 0; // ticks simulated since the level started, less whatever got rewound
+	bool rewinding = false;
+	const auto canTravel = [&]()
 		{
-			SDL_DestroyTexture(tex);
+			if (recorder.isOpen() || replay.isOpen())
+			{
+				SDL_Log("Rewinding and loading are off while recording or replaying");
+				return false;
+			}
+			return true;
+		};
+	history.push().capture(gs, level, tick);
 
-		}
-	}
-};
 
-bool initialize(SDLState& state);
-void cleanup(SDLState& state);
-void drawObject(const SDLState& state, GameState& gs, GameObject& obj, float width, float height, float deltaTime);
-void update(const SDLState& state, GameState& gs, Resources& res, GameObject& obj, float deltaTime);
-void createTiles(const SDLState& state, GameState& gs, const Resources& res);
-void checkCollision(const SDLState& state, GameState& gs, Resources& res, GameObject& a, GameObject& b, float deltaTime);
-void handleKeyInput(const SDLState& state, GameState& gs, GameObject& obj, SDL_Scancode key, bool keyDown);
-void drawParalaxBackground(SDL_Renderer* renderer, SDL_Texture* texture, float xVelocity, float& scrollPos, float scrollFactor, float deltaTime);
+	// the simulation gets a keyboard of its own, the real one changes whenever the main thread pumps events
+	SDLState simState = state;
+	bool simKeys[SDL_SCANCODE_COUNT] = {};
+	simState.keys = simKeys;
+	InputInbox input;
+	DrawListQueue drawLists; // the simulation describes each frame in one of these, the main thread draws it, see renderPipeline.h
 
-int main(int argc, char* argv[])
-{
-	SDLState state;
-	state.width = 1600;
-	state.height = 900;
-	state.logicalWidth = 640;
-	state.logicalHeight = 320;
+	std::thread simulation([&]()
+		{
+			const uint64_t counterFrequency = SDL_GetPerformanceFrequency();
+			uint64_t prevCounter = SDL_GetPerformanceCounter();
+			double accumulator = 0; // simulated time we still owe, always less than one tick after the update loop
+			float timeScale = 1.0f; // < 1 runs the simulation in slow motion, > 1 fast forwards it
+			uint64_t prevAllocationCount = heapAllocationCount();
+			uint64_t frameAllocations = 0; // operator new calls during the last frame, shown after A: in the debug text
+			std::vector<SDL_KeyboardEvent> keyEvents;
+			TileSync tileSync; // which tile chunks the main thread already has
+
+			// waits here while the main thread still draws the last frame, so this one runs while that one is presented
+			while (DrawList* list = drawLists.beginWrite())
+			{
+				PROFILE_ZONE("simulation frame");
+				uint64_t nowCounter = SDL_GetPerformanceCounter();
+				double frameTime = static_cast<double>(nowCounter - prevCounter) / counterFrequency; // seconds, with sub-ms precision
+				prevCounter = nowCounter;
 
-	if (!initialize(state))
-	{
-		return 1;
-	}
+				input.take(keyEvents, simKeys);
+				for (const SDL_KeyboardEvent& key : keyEvents)
+				{
+					if (key.down)
+					{
+						// [ and ] halve / double the simulation speed
+						if (key.scancode == SDL_SCANCODE_LEFTBRACKET)
+						{
+							timeScale = std::max(timeScale * 0.5f, 0.125f);
+						}
+						else if (key.scancode == SDL_SCANCODE_RIGHTBRACKET)
+						{
+							timeScale = std::min(timeScale * 2.0f, 8.0f);
+						}
+						// Backspace rewinds while it is held, Page Up goes back a second, F5 / F9 quick save and load
+						else if (key.scancode == SDL_SCANCODE_BACKSPACE && !key.repeat)
+						{
+							rewinding = canTravel();
+						}
+						else if (key.scancode == SDL_SCANCODE_PAGEUP && canTravel())
+						{
+							// further back than the ring goes, the oldest snapshot it has will do
+							const uint64_t second = static_cast<uint64_t>(TICK_RATE);
+							const Snapshot* snapshot = history.seek(std::max(tick > second ? tick - second : 0, history.front().tick()));
+							if (snapshot && snapshot->restore(gs, level))
+							{
+								tick = snapshot->tick();
+							}
+						}
+						else if (key.scancode == SDL_SCANCODE_F5)
+						{
+							history.back().save(QUICKSAVE_PATH);
+						}
+						else if (key.scancode == SDL_SCANCODE_F9 && canTravel())
+						{
+							Snapshot quickSave;
+							if (quickSave.load(QUICKSAVE_PATH) && quickSave.restore(gs, level))
+							{
+								tick = quickSave.tick();
+								history.clear();
+								history.push().capture(gs, level, tick);
+							}
+						}
+					}
+					else if (key.scancode == SDL_SCANCODE_BACKSPACE)
+					{
+						rewinding = false;
+					}
+					if (!replay.isOpen())
+					{
+						recorder.keyEvent(key.scancode, key.down);
+						handleKeyInput(simState, gs, gs.characters, gs.player(), key.scancode, key.down);
+					}
+				}
+				keyEvents.clear();
+				if (input.takeLevelChanged())
+				{
+					if (recorder.isOpen() || replay.isOpen())
+					{
+						SDL_Log("%s changed, a recording only plays back on the level it started with so it isn't reloaded", levelPath.c_str());
+					}
+					else
+					{
+						level.reload();
+					}
+				}
 
+			/*
+			NOTE:
+			Instead of moving the sprite an arbitrary amount per frame, we should be moving the sprite certain amount per second.
+			This is because if we use frame-based movement, the speed of the sprite will be dictated based on the speed of the machine running the game.
+			Implications arise since everyone uses different machines now. Frame-based movement used to be acceptable back in the day where developers
+			were building games exclusive to certain home consoles where everyone had the same specs.
+
+			game loop must track time so that we move sprite according to passed time rather than speed of the computer.
+
+			We can use SDL_GetTicks() to take time of when previous frame started subtracted from the time of when current frame started
+			to get length of time between the frame in ms. If we convert this to seconds we get the amount of time it takes for one frame to execute.
+
+			Feeding that variable delta straight into the simulation still means physics behaves a little differently on every machine and
+			every frame hitch. So the frame time goes into an accumulator instead and the simulation always advances in fixed TICK_TIME steps,
+			as many as fit. Whatever is left over (less than one tick) is used to blend between the last two simulated states when drawing.
+			*/
+				double simTime = std::min(frameTime * timeScale, MAX_FRAME_TIME);
+				accumulator += simTime;
+				while (accumulator >= TICK_TIME)
+				{
+					PROFILE_ZONE("simulate");
+					if (rewinding)
+					{
+						// one tick back per tick, the oldest snapshot stays so there is always somewhere to go back to
+						if (history.size() > 1)
+						{
+							history.pop();
+							history.back().restore(gs, level);
+							tick = history.back().tick();
+						}
+						accumulator -= TICK_TIME;
+						continue;
+					}
+					if (replay.isOpen() && !replay.tick(simState, gs))
+					{
+						SDL_Log("Replay finished after %u ticks, state hash %016llx", replay.getTickCount(), static_cast<unsigned long long>(stateHash(gs)));
+						replay.close();
+						simState.keys = simKeys; // the keyboard takes over from here
+					}
+					recorder.tick(simState.keys);
+					stepGame(simState, gs, res, level);
+					for (int chunk : level.evictedChunks())
+					{
+						list->evictedChunks.push_back(chunk);
+					}
+					tick++;
+					history.push().capture(gs, level, tick);
+					accumulator -= TICK_TIME;
+				}
+				const float alpha = static_cast<float>(accumulator / TICK_TIME); // how far we are between the previous and current tick
+				const float deltaTime = static_cast<float>(simTime);
+
+				// the camera is drawn from where the player is drawn, not where the last tick left it. The simulation moves it back
+				// to the tick position itself
+				PROFILE_ZONE("build draw list");
+				EntityStore& characters = gs.characters;
+				const Transform& playerTransform = characters.transform[gs.player()];
+				const Physics& playerPhysics = characters.physics[gs.player()];
+				const glm::vec2 playerPos = glm::mix(playerTransform.prevPosition, playerTransform.position, alpha);
+				gs.mapViewport.x = (playerPos.x + TILE_SIZE / 2) - gs.mapViewport.w / 2;
+				list->visibleArea = gs.visibleArea();
+				list->cameraX = gs.mapViewport.x;
+
+				// background images
+				list->sky = res.texBg1;
+				scrollParalaxBackground(res.texBg2, playerPhysics.velocity.x, gs.bg2Scroll, 0.075f, deltaTime);
+				list->parallax.push_back(ParallaxLayer{ res.texBg2, gs.bg2Scroll });
+				scrollParalaxBackground(res.texBg3, playerPhysics.velocity.x, gs.bg2Scroll, 0.150f, deltaTime);
+				list->parallax.push_back(ParallaxLayer{ res.texBg3, gs.bg2Scroll });
+				scrollParalaxBackground(res.texBg4, playerPhysics.velocity.x, gs.bg2Scroll, 0.3f, deltaTime);
+				list->parallax.push_back(ParallaxLayer{ res.texBg4, gs.bg2Scroll });
+
+				// tiles are drawn by the main thread's caches, they only need to hear about chunks that changed
+				tileSync.write(gs.tiles, *list);
 
-	// load game assets
-	//SDL texture: piece of memory holding picture on the graphics card
-	Resources res;
-	res.load(state);
+				{
+					// only ask the grid for what is near the camera instead of walking every character in the level
+					FrameVector<uint32_t> visible(&frameArena()); // grid ids of the characters near the camera
+					gs.grid.query(list->visibleArea, visible);
+					for (uint32_t id : visible)
+					{
+						drawObject(simState, gs, res, list->characters, characters, gs.colliderIndex(id), TILE_SIZE, TILE_SIZE, alpha);
+					}
+				}
+				for (size_t i = 0; i < gs.bullets.size(); i++)
+				{
+					// bullets aren't in the grid, but checking a rect per live bullet is cheap enough
+					const SDL_FRect bulletRect = gs.bullets.worldCollider(i);
+					if (!SDL_HasRectIntersectionFloat(&bulletRect, &list->visibleArea))
+					{
+						continue;
+					}
+					drawObject(simState, gs, res, list->bullets, gs.bullets, i, gs.bullets.collider[i].w, gs.bullets.collider[i].h, alpha);
+				}
 
-	// setup game data
-	GameState gs(state);
-	createTiles(state, gs, res);
+				// some debug info, D: is from the last frame the main thread finished
+				std::format_to(std::back_inserter(list->debugText), "S: {}, B: {}, G: {}, T: {}x, D: {}, C: {}, A: {}",
+					static_cast<int>(characters.data[gs.player()].player.state), gs.bullets.size(), playerPhysics.grounded, timeScale,
+					drawLists.getDrawCalls(), level.residentCount(), frameAllocations);
+				drawLists.publish();
+
+				// everything taken from the arena this frame is gone from here on
+				frameArena().reset();
+				const uint64_t allocationCount = heapAllocationCount();
+				frameAllocations = allocationCount - prevAllocationCount;
+				prevAllocationCount = allocationCount;
+			}
+		});
 
 
-	uint64_t prevTime = SDL_GetTicks();
+	// the main thread pumps events and draws the lists the simulation publishes
+	bool showProfiler = false;
+	SpriteBatch batch; // tiles get queued here and drawn with one call per texture
+	// static tile layers are baked into chunk textures once and then drawn a few big quads at a time
+	TileLayerCache backgroundCache(TILE_LAYER_BACKGROUND), levelCache(TILE_LAYER_LEVEL), foregroundCache(TILE_LAYER_FOREGROUND);
+	TileMirror tiles; // what the tile caches draw from, GameState belongs to the simulation thread
 
+	// images and the level get reloaded when they change on disk, only the files that changed
+	FileWatcher watcher;
+	for (const std::string& path : res.imagePaths)
+	{
+		watcher.add(path);
+	}
+	watcher.add(levelPath);
+	std::vector<std::string> changedFiles;
 
 
 	//start game loop
@@ -159,139 +332,180 @@ int main(int argc, char* argv[])
 
 	while (running)
 	{
-		uint64_t nowTime = SDL_GetTicks();
-		float deltaTime = (nowTime - prevTime) / 1000.0f; //convert to seconds 
+		PROFILE_ZONE("frame");
 		SDL_Event event{ 0 };
-		while (SDL_PollEvent(&event)) //keeps calling SDL Poll event which returns true if event occurs
 		{
-			switch (event.type)
-			{
-			case SDL_EVENT_QUIT:
+			PROFILE_ZONE("events");
+			while (SDL_PollEvent(&event)) //keeps calling SDL Poll event which returns true if event occurs
 			{
-				running = false;
-				break;
-			}
-			case  SDL_EVENT_WINDOW_RESIZED:
-			{
-				state.width = event.window.data1;
-				state.height = event.window.data2;
-				break;
-			}
-			case SDL_EVENT_KEY_DOWN:
-			{
-				handleKeyInput(state, gs, gs.player(), event.key.scancode, true);
-				break;
-			}
-			case SDL_EVENT_KEY_UP:
-			{
-				handleKeyInput(state, gs, gs.player(), event.key.scancode, false);
-				break;
-			}
+				switch (event.type)
+				{
+				case SDL_EVENT_QUIT:
+				{
+					running = false;
+					break;
+				}
+				case  SDL_EVENT_WINDOW_RESIZED:
+				{
+					state.width = event.window.data1;
+					state.height = event.window.data2;
+					break;
+				}
+				case SDL_EVENT_KEY_DOWN:
+				{
+					// F1 shows the profiler overlay, F2 saves the recent zones for chrome://tracing
+					if (event.key.scancode == SDL_SCANCODE_F1)
+					{
+						showProfiler = !showProfiler;
+					}
+					else if (event.key.scancode == SDL_SCANCODE_F2)
+					{
+						if (!profiler().writeChromeTrace("trace.json"))
+						{
+							SDL_Log("Could not write trace.json");
+						}
+					}
+					// everything else is up to the simulation
+					input.push(event.key);
+					break;
+				}
+				case SDL_EVENT_RENDER_TARGETS_RESET:
+				{
+					// the driver threw away what was drawn into our render targets
+					backgroundCache.invalidate();
+					levelCache.invalidate();
+					foregroundCache.invalidate();
+					break;
+				}
+				case SDL_EVENT_KEY_UP:
+				{
+					input.push(event.key);
+					break;
+				}
 
+				}
 			}
+			input.setKeys(SDL_GetKeyboardState(nullptr));
 		}
 
-		/*
-		NOTE:
-		Instead of moving the sprite an arbitrary amount per frame, we should be moving the sprite certain amount per second.
-		This is because if we use frame-based movement, the speed of the sprite will be dictated based on the speed of the machine running the game.
-		Implications arise since everyone uses different machines now. Frame-based movement used to be acceptable back in the day where developers
-		were building games exclusive to certain home consoles where everyone had the same specs.
-
-		game loop must track time so that we move sprite according to passed time rather than speed of the computer.
-
-		We can use SDL_GetTicks() to take time of when previous frame started subtracted from the time of when current frame started
-		to get length of time between the frame in ms. If we convert this to seconds we get the amount of time it takes for one frame to execute.
-		*/
-
-		// update all objects
-		for (auto& layer : gs.layers)
+		// images are decoded again on the loader's threads and uploaded here between frames. A changed level is up to the
+		// simulation, it has the streamer's worker open it and switches to it between ticks
 		{
-			for (GameObject& obj : layer)
+			PROFILE_ZONE("hot reload");
+			changedFiles.clear();
+			watcher.poll(changedFiles);
+			for (const std::string& path : changedFiles)
 			{
-				update(state, gs, res, obj, deltaTime);
-				// update Animation
-				if (obj.currentAnimation != -1)
+				if (path == levelPath)
+				{
+					input.pushLevelChanged();
+				}
+				else
 				{
-					obj.animations[obj.currentAnimation].step(deltaTime);
+					res.reloadImage(path);
 				}
 			}
+			if (res.updateReload(state.renderer))
+			{
+				// the tile caches still hold the old pixels
+				backgroundCache.invalidate();
+				levelCache.invalidate();
+				foregroundCache.invalidate();
+			}
 		}
 
-		// update bullets
-		for (GameObject& bullet : gs.bullets)
+		// the simulation builds the next list while this one is drawn. If it is stuck on something long (loading a save)
+		// we come back for it after pumping the events again, so the window stays responsive
+		const DrawList* list = nullptr;
 		{
-			update(state, gs, res, bullet, deltaTime);
-
-			// update the animation
-			if (bullet.currentAnimation != -1)
-			{
-				bullet.animations[bullet.currentAnimation].step(deltaTime);
-			}
+			PROFILE_ZONE("wait for simulation");
+			list = drawLists.acquire(100);
+		}
+		if (!list)
+		{
+			continue;
+		}
+		tiles.apply(*list);
+		for (int chunk : list->evictedChunks)
+		{
+			backgroundCache.releaseChunk(chunk);
+			levelCache.releaseChunk(chunk);
+			foregroundCache.releaseChunk(chunk);
 		}
-		// calculate viewport position
-		gs.mapViewport.x = (gs.player().position.x + TILE_SIZE / 2) - gs.mapViewport.w / 2;
 
 		// perform drawing commands
 		SDL_SetRenderDrawColor(state.renderer, 20, 10, 30, 255);
 		SDL_RenderClear(state.renderer);
 
 		// draw background images
-		SDL_RenderTexture(state.renderer, res.texBg1, nullptr, nullptr);
-		drawParalaxBackground(state.renderer, res.texBg2, gs.player().velocity.x, gs.bg2Scroll, 0.075f, deltaTime);
-		drawParalaxBackground(state.renderer, res.texBg3, gs.player().velocity.x, gs.bg2Scroll, 0.150f, deltaTime);
-		drawParalaxBackground(state.renderer, res.texBg4, gs.player().velocity.x, gs.bg2Scroll, 0.3f, deltaTime);
+		{
+			PROFILE_ZONE("draw parallax");
+			SDL_RenderTexture(state.renderer, list->sky.texture, &list->sky.area, nullptr);
+			for (const ParallaxLayer& layer : list->parallax)
+			{
+				drawParalaxBackground(state.renderer, layer.sprite, layer.x);
+			}
+		}
 
 
 		// draw background tiles
-		for (GameObject& obj : gs.backgroundTiles)
 		{
-			SDL_FRect dst{
-				.x = obj.position.x - gs.mapViewport.x,
-				.y = obj.position.y,
-				.w = static_cast<float>(obj.texture->w),
-				.h = static_cast<float>(obj.texture->h),
-			};
-			SDL_RenderTexture(state.renderer, obj.texture, nullptr, &dst);
+			PROFILE_ZONE("draw bg tiles");
+			backgroundCache.draw(state.renderer, batch, tiles.get(), list->visibleArea, list->cameraX);
+			batch.flush(state.renderer);
 		}
 		//draw all objects
-		for (auto& layer : gs.layers)
 		{
-			for (GameObject& obj : layer)
-			{
-				drawObject(state, gs, obj, TILE_SIZE, TILE_SIZE, deltaTime);
-			}
+			PROFILE_ZONE("draw level tiles");
+			levelCache.draw(state.renderer, batch, tiles.get(), list->visibleArea, list->cameraX);
+			batch.flush(state.renderer);
 		}
-		// draw bullets
-		for (GameObject& bullet : gs.bullets)
+		size_t spriteDrawCalls = 0;
 		{
-			drawObject(state, gs, bullet, bullet.collider.w, bullet.collider.h, deltaTime);
+			PROFILE_ZONE("draw sprites");
+			spriteDrawCalls += list->characters.submit(state.renderer);
+			spriteDrawCalls += list->bullets.submit(state.renderer);
 		}
 
 		// draw foreground tiles
-		for (GameObject& obj : gs.foregroundTiles)
 		{
-			SDL_FRect dst{
-				.x = obj.position.x - gs.mapViewport.x,
-				.y = obj.position.y,
-				.w = static_cast<float>(obj.texture->w),
-				.h = static_cast<float>(obj.texture->h),
-			};
-			SDL_RenderTexture(state.renderer, obj.texture, nullptr, &dst);
+			PROFILE_ZONE("draw fg tiles");
+			foregroundCache.draw(state.renderer, batch, tiles.get(), list->visibleArea, list->cameraX);
+			batch.flush(state.renderer);
 		}
 
 		// display some debug info
 		SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
-		SDL_RenderDebugText(state.renderer, 5, 5,
-			std::format("S: {}, B: {}, G: {}", static_cast<int>(gs.player().data.player.state), gs.bullets.size(), gs.player().grounded).c_str());
+		SDL_RenderDebugText(state.renderer, 5, 5, list->debugText.c_str());
+		drawLists.setDrawCalls(batch.getDrawCalls() + spriteDrawCalls);
+		batch.resetDrawCalls();
+		// timings are from the frames before this one, this frame's zones are still open
+		if (showProfiler)
+		{
+			profiler().drawOverlay(state.renderer, 5, 20);
+		}
 
 		//swap buffers and present
-		SDL_RenderPresent(state.renderer);
-		prevTime = nowTime;
-
+		{
+			PROFILE_ZONE("present");
+			SDL_RenderPresent(state.renderer);
+		}
+		profiler().endFrame();
 	}
+	drawLists.close();
+	simulation.join();
 
 
+	if (recorder.isOpen())
+	{
+		SDL_Log("Recorded %s, state hash %016llx", recordPath, static_cast<unsigned long long>(stateHash(gs)));
+		recorder.close();
+	}
+	level.close();
+	jobs().stop();
+	backgroundCache.release();
+	levelCache.release();
+	foregroundCache.release();
 	res.unload();
 	cleanup(state);
 	return 0;
@@ -342,452 +556,38 @@ void cleanup(SDLState& state)
 	SDL_Quit();
 }
 
-void drawObject(const SDLState& state, GameState& gs, GameObject& obj, float width, float height, float deltaTime)
-{
-
-	// first frame = 0 * 32, second frame = 1 * 32, etc... as the animation moves forward, srcX value points to new starting x pos in the sprite spreadsheet. 
-	float srcX = obj.currentAnimation != -1
-		? obj.animations[obj.currentAnimation].currentFrame() * width : 0.0f;
-
-	float srcY = 0.0f;
-
-	if (obj.currentAnimation != -1)
-	{
-		srcY = obj.animations[obj.currentAnimation].getRowIndex() * width;
-	}
-
-	SDL_FRect src{
-		.x = srcX,
-		.y = srcY,
-		.w = width,
-		.h = height
-	};
-
-	//destination of the sprite
-	SDL_FRect dst{
-		.x = obj.position.x - gs.mapViewport.x, //setting horizontal position of player in destination rect of drawing code
-		.y = obj.position.y,
-		.w = width,
-		.h = height
-	};
-
-	SDL_FlipMode flipMode = obj.direction == -1 ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-	SDL_RenderTextureRotated(state.renderer, obj.texture, &src, &dst, 0, nullptr, flipMode);
-
-}
-
-void update(const SDLState& state, GameState& gs, Resources& res, GameObject& obj, float deltaTime)
-{
-	if (obj.dynamic)
-	{
-		// applying gravity
-		obj.velocity += glm::vec2(0, 500) * deltaTime;
-	}
-
-
-	float currentDirection = 0;
-	if (obj.type == ObjectType::player)
-	{
-
-		if (state.keys[SDL_SCANCODE_A])
-		{
-			currentDirection += -1;
-		}
-		if (state.keys[SDL_SCANCODE_D])
-		{
-			currentDirection += 1;
-		}
-		if (currentDirection)
-		{
-			obj.direction = currentDirection;
-		}
-		Timer& weaponTimer = obj.data.player.weaponTimer;
-		weaponTimer.step(deltaTime);
-
-		switch (obj.data.player.state)
-		{
-		case PlayerState::idle:
-		{
-			// switch to running state
-			if (currentDirection)
-			{
-				obj.data.player.state = PlayerState::running;
-			}
-			else
-			{
-				// decelerate
-				if (obj.velocity.x)
-				{
-					const float factor = obj.velocity.x > 0 ? -1.5f : 1.5f;
-					float amount = factor * obj.acceleration.x * deltaTime;
-					if (std::abs(obj.velocity.x) < std::abs(amount))
-					{
-						obj.velocity.x = 0;
-					}
-					else
-					{
-						obj.velocity.x += amount;
-					}
-				}
-			}
-			if (state.keys[SDL_SCANCODE_J])
-			{
-				if (weaponTimer.isTimeout())
-				{
-					weaponTimer.reset();
-					// spawn some bullets
-					GameObject bullet;
-					bullet.type = ObjectType::bullet;
-					bullet.direction = gs.player().direction;
-					bullet.texture = res.texBullet;
-					bullet.currentAnimation = res.ANIM_BULLET_MOVING;
-					bullet.collider = SDL_FRect{
-						.x = 0,
-						.y = 0,
-						.w = static_cast<float>(res.texBullet->h),
-						.h = static_cast<float>(res.texBullet->h),
-					};
-					bullet.velocity = glm::vec2(
-						obj.velocity.x + 600.0f * obj.direction,
-						0
-					);
-					bullet.animations = res.bulletAnims;
-
-					// adjust bullet start position
-					const float left = 4;
-					const float right = 24;
-					const float t = (obj.direction + 1) / 2.0f; // results in a value of 0 .. 1
-					const float xOffset = left + right * t; // LERP between left and right based on direction
-					bullet.position = glm::vec2(
-						obj.position.x + xOffset,
-						obj.position.y + TILE_SIZE / 2
-					);
-					gs.bullets.push_back(bullet);
-				}
-			}
-			obj.texture = res.texIdle;
-			obj.currentAnimation = res.ANIM_PLAYER_IDLE;
-			break;
-		}
-		case PlayerState::running:
-		{
-			// switching to idle state
-			if (!currentDirection)
-			{
-				obj.data.player.state = PlayerState::idle;
-				obj.texture = res.texIdle;
-				obj.currentAnimation = res.ANIM_PLAYER_IDLE;
-			}
-			// moving in opposite direction of velocity
-			if (obj.velocity.x * obj.direction < 0 && obj.grounded)
-			{
-				obj.texture = res.texSlide;
-				obj.currentAnimation = res.ANIM_PLAYER_SLIDE;
-			}
-			else
-			{
-				obj.texture = res.texRun;
-				obj.currentAnimation = res.ANIM_PLAYER_RUN;
-			}
-
-			break;
-		}
-		case PlayerState::jumping:
-		{
-			obj.texture = res.texJump;
-			obj.currentAnimation = res.ANIM_PLAYER_JUMP;
-			break;
-		}
-		}
-	}
-
-	// add acceleration to velocity
-	obj.velocity += currentDirection * obj.acceleration * deltaTime;
-	if (std::abs(obj.velocity.x) > obj.maxSpeedX)
-	{
-		obj.velocity.x = currentDirection * obj.maxSpeedX;
-	}
-
-	// add velocity to position
-	obj.position += obj.velocity * deltaTime;
-
-	// handle collision detection
-	bool foundGround = false;
-	for (auto& layer : gs.layers)
-	{
-		for (GameObject& objB : layer)
-		{
-			if (&obj != &objB)
-			{
-				checkCollision(state, gs, res, obj, objB, deltaTime);
-				// grounded sensor
-				SDL_FRect sensor{
-					.x = obj.position.x + obj.collider.x,
-					.y = obj.position.y + obj.collider.y + obj.collider.h,
-					.w = obj.collider.w,
-					.h = 1
-				};
-				SDL_FRect rectB{
-					.x = objB.position.x + objB.collider.x,
-					.y = objB.position.y + objB.collider.y,
-					.w = objB.collider.w,
-					.h = objB.collider.h
-				};
-				if (SDL_HasRectIntersectionFloat(&sensor, &rectB))
-				{
-					foundGround = true;
-				}
-			}
-		}
-	}
-	if (obj.grounded != foundGround)
-	{
-		// swithing grounded state
-		obj.grounded = foundGround;
-		if (obj.grounded == foundGround && obj.type == ObjectType::player)
-		{
-			obj.data.player.state = PlayerState::running;
-		}
-	}
-}
-
-void collisionResponse(const SDLState& state, GameState& gs, Resources& res, const SDL_FRect& rectA, const SDL_FRect& rectB,
-	const SDL_FRect& rectC, GameObject& objA, GameObject& objB, float deltaTime)
+// images are decoded in the background, until they are all uploaded we just draw a progress bar
+// returns false if the window was closed before loading finished
+bool drawLoadingScreen(SDLState& state, Resources& res)
 {
-	// object to check
-	if (objA.type == ObjectType::player)
+	while (!res.updateLoad(state.renderer))
 	{
-		// object it is colliding with
-		switch (objB.type)
-		{
-		case ObjectType::level:
+		SDL_Event event{ 0 };
+		while (SDL_PollEvent(&event))
 		{
-			// if player collides with level object the height of rectC would be much greater than the width
-			// we resolve the collision by increasing the height of player by the height of rectC and vice versa for horizontally colliding 
-			if (rectC.w < rectC.h)
-			{
-				// horizontal collision
-
-				if (objA.velocity.x > 0)
-				{
-					objA.position.x -= rectC.w; // going right
-				}
-				else if (objA.velocity.x < 0)
-				{
-					objA.position.x += rectC.w; // going left
-				}
-				objA.velocity.x = 0;
-			}
-			else
+			if (event.type == SDL_EVENT_QUIT)
 			{
-				// vertical collision
-
-				if (objA.velocity.y > 0)
-				{
-					objA.position.y -= rectC.h; // going down
-				}
-				else if (objA.velocity.y < 0)
-				{
-					objA.position.y += rectC.h; // going up
-				}
-				objA.velocity.y = 0;
+				return false;
 			}
-			break;
-		}
-
 		}
-	}
-}
-
-
-//rect A, B, C are representing hitboxes to see if two gameObjects are intersecting
-//rect c will show how far two objects are overlapping
-void checkCollision(const SDLState& state, GameState& gs, Resources& res, GameObject& a, GameObject& b, float deltaTime)
-{
-	SDL_FRect rectA{
-		.x = a.position.x + a.collider.x,
-		.y = a.position.y + a.collider.y,
-		.w = a.collider.w,
-		.h = a.collider.h
-	};
-	SDL_FRect rectB{
-		.x = b.position.x + b.collider.x,
-		.y = b.position.y + b.collider.y,
-		.w = b.collider.w,
-		.h = b.collider.h
-	};
-	SDL_FRect rectC{ 0 };
-
-	if (SDL_GetRectIntersectionFloat(&rectA, &rectB, &rectC))
-	{
-		// found the intersection
-		collisionResponse(state, gs, res, rectA, rectB, rectC, a, b, deltaTime);
-	}
-}
-void createTiles(const SDLState& state, GameState& gs, const Resources& res)
-{
-	/*
-	1 - ground
-	2 - panel
-	3 - enemy
-	4 - player
-	5 - grass
-	6 - brick
-	*/
-	short map[MAP_ROWS][MAP_COLS] = {
-		0, 0, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 2, 2, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 0, 0, 2, 0, 2, 0, 0, 0, 0, 0, 0, 2, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	};
-
-	short foreground[MAP_ROWS][MAP_COLS] = {
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		5, 0, 0, 5, 5, 5, 5, 5, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	};
-
-	short background[MAP_ROWS][MAP_COLS] = {
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 6, 6, 6, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 6, 6, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-		0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	};
-
-	const auto loadMap = [&state, &gs, &res](short layer[MAP_ROWS][MAP_COLS])
-		{
-			const auto createObject = [&state](int r, int c, SDL_Texture* tex, ObjectType type)
-				{
-					GameObject o;
-					o.type = type;
-					o.position = glm::vec2(c * TILE_SIZE, state.logicalHeight - (MAP_ROWS - r) * TILE_SIZE);
-					o.texture = tex;
-					o.collider = {
-						.x = 0,
-						.y = 0,
-						.w = TILE_SIZE,
-						.h = TILE_SIZE
-					};
-					return o;
-				};
-
-			for (int r = 0; r < MAP_ROWS; r++)
-			{
-				for (int c = 0; c < MAP_COLS; c++)
-				{
-					switch (layer[r][c])
-					{
-					case 1:
-					{
-						GameObject o = createObject(r, c, res.texGround, ObjectType::level);
-						gs.layers[LAYER_IDX_LEVEL].push_back(o);
-						break;
-					}
-
-					case 2:
-					{
-						GameObject o = createObject(r, c, res.texPanel, ObjectType::level);
-						gs.layers[LAYER_IDX_LEVEL].push_back(o);
-						break;
-					}
 
-					case 4: // player
-					{
-
-						GameObject player = createObject(r, c, res.texIdle, ObjectType::player);
-						player.data.player = PlayerData();
-						player.animations = res.playerAnims;
-						player.currentAnimation = res.ANIM_PLAYER_IDLE;
-						player.acceleration = glm::vec2(300, 0);
-						player.maxSpeedX = 100;
-						player.dynamic = true;
-						player.collider = {
-							.x = 11,
-							.y = 6,
-							.w = 10,
-							.h = 26
-						};
-
-						gs.layers[LAYER_IDX_CHARACTERS].push_back(player);
-						gs.playerIndex = gs.layers[LAYER_IDX_CHARACTERS].size() - 1;
-
-						break;
-					}
-					case 5: // grass
-					{
-						GameObject o = createObject(r, c, res.texGrass, ObjectType::level);
-						gs.foregroundTiles.push_back(o);
-						break;
-					}
-					case 6: // brick
-					{
-						GameObject o = createObject(r, c, res.texBrick, ObjectType::level);
-						gs.backgroundTiles.push_back(o);
-						break;
-					}
-					}
-				}
-			}
+		const float barWidth = state.logicalWidth * 0.5f;
+		SDL_FRect outline{
+			.x = (state.logicalWidth - barWidth) / 2,
+			.y = state.logicalHeight / 2.0f - 4,
+			.w = barWidth,
+			.h = 8
 		};
-	loadMap(map);
-	loadMap(background);
-	loadMap(foreground);
-	assert(gs.playerIndex != -1);
-}
-
-void handleKeyInput(const SDLState& state, GameState& gs, GameObject& obj,
-	SDL_Scancode key, bool keyDown)
-{
-
-	const float JUMP_FORCE = -200.0f;
-	if (obj.type == ObjectType::player)
-	{
-		switch (obj.data.player.state)
-		{
-		case PlayerState::idle:
-		{
-			if (key == SDL_SCANCODE_K && keyDown)
-			{
-				obj.data.player.state = PlayerState::jumping;
-				obj.velocity.y += JUMP_FORCE;
+		SDL_FRect fill = outline;
+		fill.w *= res.loadProgress();
 
-			}
-			break;
-		}
-		case PlayerState::running:
-		{
-			if (key == SDL_SCANCODE_K && keyDown)
-			{
-				obj.data.player.state = PlayerState::jumping;
-				obj.velocity.y += JUMP_FORCE;
-			}
-			break;
-		}
-		}
+		SDL_SetRenderDrawColor(state.renderer, 20, 10, 30, 255);
+		SDL_RenderClear(state.renderer);
+		SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
+		SDL_RenderDebugText(state.renderer, outline.x, outline.y - 14, "Loading...");
+		SDL_RenderFillRect(state.renderer, &fill);
+		SDL_RenderRect(state.renderer, &outline);
+		SDL_RenderPresent(state.renderer);
 	}
+	return true;
 }
-
-
-// as our player walks towards the right, the background moves towards the left relative to the movement speed of the character
-void drawParalaxBackground(SDL_Renderer* renderer, SDL_Texture* texture,
-	float xVelocity, float& scrollPos, float scrollFactor, float deltaTime)
-{
-	scrollPos -= xVelocity * scrollFactor * deltaTime;
-	if (scrollPos <= -texture->w)
-	{
-		scrollPos = 0;
-	}
-
-	SDL_FRect dst{
-		.x = scrollPos,
-		.y = 10,
-		.w = texture->w * 2.0f,
-		.h = static_cast<float>(texture->h)
-
-	};
-	SDL_RenderTextureTiled(renderer, texture, nullptr, 1, &dst);
-}
\ No newline at end of file
@@ -0,0 +1,134 @@
+// snapshot.cpp : Captures and restores the simulation state, see snapshot.h.
+//
+
+#include "snapshot.h"
+
+static uint32_t checksum(const uint8_t* data, size_t size)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+void Snapshot::capture(const GameState& gs, const LevelStreamer& level, uint64_t tick)
+{
+	PROFILE_ZONE("snapshot");
+	SnapshotHeader header{};
+	std::memcpy(header.magic, "SNP1", 4);
+	header.version = SNAPSHOT_VERSION;
+	header.tick = tick;
+	header.maxBullets = static_cast<uint32_t>(gs.bullets.capacity());
+	header.levelCols = gs.tiles.getCols();
+	header.levelRows = gs.tiles.getRows();
+	header.levelSpawns = static_cast<uint32_t>(level.spawnPointCount());
+	header.playerEntity = gs.playerEntity;
+	header.mapViewport = gs.mapViewport;
+	header.bg2Scroll = gs.bg2Scroll;
+	header.bg3Scroll = gs.bg3Scroll;
+	header.bg4Scroll = gs.bg4Scroll;
+
+	bytes.clear();
+	SnapshotWriter out(bytes);
+	out.write(header);
+	gs.characters.capture(out);
+	gs.bullets.capture(out);
+	level.capture(out);
+	reinterpret_cast<SnapshotHeader*>(bytes.data())->size = static_cast<uint32_t>(bytes.size());
+}
+
+bool Snapshot::restore(GameState& gs, LevelStreamer& level) const
+{
+	PROFILE_ZONE("restore snapshot");
+	if (bytes.size() < sizeof(SnapshotHeader))
+	{
+		return false;
+	}
+	const SnapshotHeader& h = header();
+	if (h.maxBullets != gs.bullets.capacity() || h.levelCols != gs.tiles.getCols() || h.levelRows != gs.tiles.getRows() ||
+		h.levelSpawns != level.spawnPointCount())
+	{
+		SDL_Log("Snapshot of tick %llu is for another level or bullet pool, not restoring it", static_cast<unsigned long long>(h.tick));
+		return false;
+	}
+
+	// the grid follows the characters, everything in it now gets taken out and whatever comes back put in again
+	for (size_t i = 0; i < gs.characters.size(); i++)
+	{
+		gs.grid.remove(GameState::colliderId(gs.characters.entityAt(i)));
+	}
+	SnapshotReader in(bytes.data() + sizeof(SnapshotHeader), bytes.size() - sizeof(SnapshotHeader));
+	const bool restored = gs.characters.restore(in) && gs.bullets.restore(in) && level.restore(in, gs);
+	for (size_t i = 0; i < gs.characters.size(); i++)
+	{
+		gs.grid.insert(GameState::colliderId(gs.characters.entityAt(i)), gs.characters.worldCollider(i));
+	}
+	if (!restored)
+	{
+		// save files are checked when they are loaded and the ring is only ever filled by capture(), so this is a bug
+		SDL_Log("Snapshot of tick %llu doesn't add up, the game state is broken now", static_cast<unsigned long long>(h.tick));
+		return false;
+	}
+	gs.playerEntity = h.playerEntity;
+	gs.mapViewport = h.mapViewport;
+	gs.bg2Scroll = h.bg2Scroll;
+	gs.bg3Scroll = h.bg3Scroll;
+	gs.bg4Scroll = h.bg4Scroll;
+	return true;
+}
+
+bool Snapshot::save(const std::string& path) const
+{
+	if (bytes.empty())
+	{
+		return false;
+	}
+	SnapshotHeader h = header();
+	h.checksum = checksum(bytes.data() + sizeof(SnapshotHeader), bytes.size() - sizeof(SnapshotHeader));
+
+	// written under a temporary name first so a crash halfway never replaces the last good save with a broken one
+	const std::string temporary = path + ".tmp";
+	SDL_IOStream* io = SDL_IOFromFile(temporary.c_str(), "wb");
+	if (!io)
+	{
+		SDL_Log("Could not create %s: %s", temporary.c_str(), SDL_GetError());
+		return false;
+	}
+	const size_t rest = bytes.size() - sizeof(SnapshotHeader);
+	bool success = SDL_WriteIO(io, &h, sizeof(h)) == sizeof(h) && SDL_WriteIO(io, bytes.data() + sizeof(SnapshotHeader), rest) == rest;
+	success = SDL_CloseIO(io) && success;
+	if (!success || !SDL_RenamePath(temporary.c_str(), path.c_str()))
+	{
+		SDL_Log("Could not write %s", path.c_str());
+		SDL_RemovePath(temporary.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool Snapshot::load(const std::string& path)
+{
+	size_t size = 0;
+	uint8_t* contents = static_cast<uint8_t*>(SDL_LoadFile(path.c_str(), &size));
+	if (!contents)
+	{
+		SDL_Log("Could not open %s: %s", path.c_str(), SDL_GetError());
+		return false;
+	}
+	const SnapshotHeader* h = reinterpret_cast<const SnapshotHeader*>(contents);
+	const bool valid = size >= sizeof(SnapshotHeader) && std::memcmp(h->magic, "SNP1", 4) == 0 && h->version == SNAPSHOT_VERSION &&
+		h->size == size && h->checksum == checksum(contents + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader));
+	if (valid)
+	{
+		bytes.assign(contents, contents + size);
+	}
+	else
+	{
+		SDL_Log("%s is not a snapshot this version can load", path.c_str());
+	}
+	SDL_free(contents);
+	return valid;
+}
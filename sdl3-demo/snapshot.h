@@ -0,0 +1,175 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "game.h"
+
+/*
+NOTE: Everything the simulation changes is plain data in a few arrays: the components and handle tables of the two entity
+stores, a handful of GameState fields, and which chunks the LevelStreamer has active along with the enemy it spawned for
+each spawn point. Tiles only ever come from the level file and the grid and scratch lists are rebuilt from the entities,
+so none of those are stored. Entities don't point anywhere either, sprites and animation clips are indices into Resources.
+A snapshot copies those arrays back to back into one block of bytes, which is a few memcpys and no allocations once the
+block has grown to size. Restoring copies them back and reinserts the characters into the grid. The game keeps the last
+few seconds of ticks in a SnapshotRing to rewind through, and writes one to a file for a quick save.
+A snapshot only goes back into the same level with the same bullet pool size, and is only read by the build that wrote
+it (native endianness and struct layout):
+
+	SnapshotHeader
+	characters, then bullets: count, slot count, free slot count, the slot tables, then every component array
+	the streamer: chunk count, spawn count, active chunk count, the active chunks, the entity spawned per spawn point
+*/
+const uint32_t SNAPSHOT_VERSION = 1;
+const float REWIND_SECONDS = 5.0f; // how much of the past the game keeps snapshots of
+const char* const QUICKSAVE_PATH = "quicksave.snp"; // F5 writes it, F9 reads it back
+
+struct SnapshotHeader
+{
+	char magic[4]; // "SNP1"
+	uint32_t version;
+	uint32_t size; // bytes in the snapshot, this header included
+	uint32_t checksum; // FNV-1a of everything after the header, only filled in for files so a damaged one is refused
+	uint64_t tick; // tick the snapshot was taken after, counted by whoever captures them
+	uint32_t maxBullets; // capacity of the bullet pool
+	int32_t levelCols, levelRows;
+	uint32_t levelSpawns; // spawn points of the streamed level, 0 without one
+	Entity playerEntity;
+	SDL_FRect mapViewport;
+	float bg2Scroll, bg3Scroll, bg4Scroll;
+};
+static_assert(sizeof(SnapshotHeader) == 80, "snapshot files start with this, keep its size");
+
+// appends plain data to the bytes of a snapshot
+class SnapshotWriter
+{
+	std::vector<uint8_t>& bytes;
+
+public:
+	explicit SnapshotWriter(std::vector<uint8_t>& bytes) : bytes(bytes)
+	{
+	}
+
+	template<typename T>
+	void write(const T* values, size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "a snapshot can only hold plain data");
+		const size_t offset = bytes.size();
+		bytes.resize(offset + count * sizeof(T));
+		if (count)
+		{
+			std::memcpy(bytes.data() + offset, values, count * sizeof(T));
+		}
+	}
+	template<typename T>
+	void write(const T& value)
+	{
+		write(&value, 1);
+	}
+};
+
+// reads back what a SnapshotWriter wrote, in the same order. Returns false instead of reading past the end
+class SnapshotReader
+{
+	const uint8_t* next;
+	const uint8_t* end;
+
+public:
+	SnapshotReader(const uint8_t* data, size_t size) : next(data), end(data + size)
+	{
+	}
+
+	template<typename T>
+	bool read(T* values, size_t count)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "a snapshot can only hold plain data");
+		if (count > static_cast<size_t>(end - next) / sizeof(T))
+		{
+			return false;
+		}
+		if (count)
+		{
+			std::memcpy(values, next, count * sizeof(T));
+		}
+		next += count * sizeof(T);
+		return true;
+	}
+	template<typename T>
+	bool read(T& value)
+	{
+		return read(&value, 1);
+	}
+};
+
+class Snapshot
+{
+	std::vector<uint8_t> bytes; // keeps its capacity, so capturing into a snapshot that was used before doesn't allocate
+
+	const SnapshotHeader& header() const { return *reinterpret_cast<const SnapshotHeader*>(bytes.data()); }
+
+public:
+	// copies the simulation state of gs and level into this snapshot, replacing what it held
+	void capture(const GameState& gs, const LevelStreamer& level, uint64_t tick);
+	// puts gs and level back into the captured state, returns false and leaves them alone if the snapshot is for another
+	// level or bullet pool size
+	bool restore(GameState& gs, LevelStreamer& level) const;
+
+	// quick save / load, load() checks the file is a snapshot this build wrote and wasn't damaged
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+	bool empty() const { return bytes.empty(); }
+	size_t size() const { return bytes.size(); }
+	uint64_t tick() const { return header().tick; }
+};
+
+// the last capacity snapshots in the order they were taken, once full every new one replaces the oldest
+class SnapshotRing
+{
+	std::vector<Snapshot> snapshots;
+	size_t first = 0; // oldest
+	size_t count = 0;
+
+public:
+	explicit SnapshotRing(size_t capacity) : snapshots(capacity)
+	{
+	}
+
+	// the snapshot to capture the next tick into
+	Snapshot& push()
+	{
+		if (count == snapshots.size())
+		{
+			first = (first + 1) % snapshots.size();
+			count--;
+		}
+		Snapshot& snapshot = snapshots[(first + count) % snapshots.size()];
+		count++;
+		return snapshot;
+	}
+	// forgets the newest snapshot, stepping back one tick
+	void pop()
+	{
+		if (count)
+		{
+			count--;
+		}
+	}
+	// forgets every snapshot newer than tick and returns the newest one left, nullptr if there are none that old
+	const Snapshot* seek(uint64_t tick)
+	{
+		while (count && back().tick() > tick)
+		{
+			count--;
+		}
+		return count ? &back() : nullptr;
+	}
+	void clear() { count = 0; }
+
+	size_t size() const { return count; }
+	size_t capacity() const { return snapshots.size(); }
+	const Snapshot& back() const { return snapshots[(first + count - 1) % snapshots.size()]; }
+	const Snapshot& front() const { return snapshots[first]; }
+};
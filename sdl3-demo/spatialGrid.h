@@ -0,0 +1,168 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/*
+NOTE: Checking every object against every other object every frame is O(N^2), which falls apart once a level has a few thousand tiles.
+A uniform grid buckets each collider into every cell its hitbox touches. To find out what overlaps a rect we only have to look
+at the handful of cells under that rect instead of the whole level.
+The cells are one flat table over the level, set up by reset() when a level is loaded. Every bucket gets room for
+BUCKET_CAPACITY ids right then, so characters walking into cells nobody has been in yet don't allocate in the middle of a
+tick. Only a cell more crowded than it ever was still grows its bucket, once. Anything outside the level is kept in the
+nearest edge cell, which is never wrong for a broadphase, just less picky.
+*/
+class SpatialGrid
+{
+public:
+	static const size_t BUCKET_CAPACITY = 8;
+
+private:
+	struct CellRange
+	{
+		int x0, y0, x1, y1;
+		bool operator==(const CellRange& other) const
+		{
+			return x0 == other.x0 && y0 == other.y0 && x1 == other.x1 && y1 == other.y1;
+		}
+	};
+
+	float cellSize;
+	float originX = 0, originY = 0; // top left corner of cell 0, 0
+	int columns = 1, rows = 1;
+	// ids of the colliders touching each cell, row by row
+	std::vector<std::vector<uint32_t>> cells;
+	std::vector<CellRange> ranges; // indexed by id, the cells it is currently stored in, x0 > x1 when it isn't stored
+
+	bool stored(uint32_t id) const
+	{
+		return id < ranges.size() && ranges[id].x0 <= ranges[id].x1;
+	}
+	CellRange cellRange(const SDL_FRect& rect) const
+	{
+		const auto cell = [this](float position, float origin, int count)
+			{
+				return static_cast<int>(std::clamp(std::floor((position - origin) / cellSize), 0.0f, static_cast<float>(count - 1)));
+			};
+		return CellRange{
+			.x0 = cell(rect.x, originX, columns),
+			.y0 = cell(rect.y, originY, rows),
+			.x1 = cell(rect.x + rect.w, originX, columns),
+			.y1 = cell(rect.y + rect.h, originY, rows)
+		};
+	}
+	void addToCells(uint32_t id, const CellRange& range)
+	{
+		for (int cy = range.y0; cy <= range.y1; cy++)
+		{
+			for (int cx = range.x0; cx <= range.x1; cx++)
+			{
+				cells[cy * columns + cx].push_back(id);
+			}
+		}
+	}
+	void removeFromCells(uint32_t id, const CellRange& range)
+	{
+		for (int cy = range.y0; cy <= range.y1; cy++)
+		{
+			for (int cx = range.x0; cx <= range.x1; cx++)
+			{
+				std::vector<uint32_t>& bucket = cells[cy * columns + cx];
+				auto found = std::find(bucket.begin(), bucket.end(), id);
+				if (found != bucket.end())
+				{
+					// order inside a bucket doesn't matter so swap with the last entry instead of shifting everything down
+					*found = bucket.back();
+					bucket.pop_back();
+				}
+			}
+		}
+	}
+
+public:
+	// covers nothing until reset(), everything shares a single cell until then
+	SpatialGrid(float cellSize) : cellSize(cellSize), cells(1)
+	{
+	}
+
+	// drops everything and lays the cells out over bounds, call it whenever a level is loaded
+	void reset(const SDL_FRect& bounds)
+	{
+		originX = bounds.x;
+		originY = bounds.y;
+		columns = std::max(1, static_cast<int>(std::ceil(bounds.w / cellSize)));
+		rows = std::max(1, static_cast<int>(std::ceil(bounds.h / cellSize)));
+		cells.assign(static_cast<size_t>(columns) * rows, std::vector<uint32_t>());
+		for (std::vector<uint32_t>& bucket : cells)
+		{
+			bucket.reserve(BUCKET_CAPACITY);
+		}
+		ranges.clear();
+	}
+
+	void insert(uint32_t id, const SDL_FRect& rect)
+	{
+		if (id >= ranges.size())
+		{
+			ranges.resize(id + 1, CellRange{ 1, 0, 0, 0 });
+		}
+		CellRange range = cellRange(rect);
+		ranges[id] = range;
+		addToCells(id, range);
+	}
+	void remove(uint32_t id)
+	{
+		if (stored(id))
+		{
+			removeFromCells(id, ranges[id]);
+			ranges[id] = CellRange{ 1, 0, 0, 0 };
+		}
+	}
+	// called after a dynamic object moves, buckets are only touched when it actually crosses into different cells
+	void move(uint32_t id, const SDL_FRect& rect)
+	{
+		if (!stored(id))
+		{
+			insert(id, rect);
+			return;
+		}
+		CellRange range = cellRange(rect);
+		if (range == ranges[id])
+		{
+			return;
+		}
+		removeFromCells(id, ranges[id]);
+		addToCells(id, range);
+		ranges[id] = range;
+	}
+	// collects the ids of everything stored in the cells under rect, callers still do the exact overlap test.
+	// out is a std::vector<uint32_t> or a FrameVector<uint32_t>
+	template<typename Vector>
+	void query(const SDL_FRect& rect, Vector& out) const
+	{
+		out.clear();
+		CellRange range = cellRange(rect);
+		for (int cy = range.y0; cy <= range.y1; cy++)
+		{
+			for (int cx = range.x0; cx <= range.x1; cx++)
+			{
+				const std::vector<uint32_t>& bucket = cells[cy * columns + cx];
+				out.insert(out.end(), bucket.begin(), bucket.end());
+			}
+		}
+		// a collider spanning several cells shows up once per cell
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+	// empties every cell but keeps the layout and the buckets' memory
+	void clear()
+	{
+		for (std::vector<uint32_t>& bucket : cells)
+		{
+			bucket.clear();
+		}
+		ranges.clear();
+	}
+};
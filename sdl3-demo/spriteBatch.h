@@ -0,0 +1,123 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <utility>
+#include <vector>
+#include "atlas.h"
+
+/*
+NOTE: Every SDL_RenderTexture call is a separate submission to the renderer, and with a few thousand tiles and sprites on
+screen that overhead adds up quickly. The batch instead turns every sprite into a quad (4 vertices, 6 indices) and keeps
+one vertex/index list per texture. flush() then hands each list to SDL_RenderGeometry in a single call, so a whole layer
+costs one call per texture no matter how many sprites are in it.
+Sprites sharing a layer get drawn grouped by texture, so anything that has to appear on top of something else needs to
+go in a later flush.
+*/
+class SpriteBatch
+{
+	struct Batch
+	{
+		SDL_Texture* texture;
+		std::vector<SDL_Vertex> vertices;
+		std::vector<int> indices;
+	};
+	std::vector<Batch> batches; // kept between frames so the vectors hold on to their memory
+	size_t used = 0; // batches[0..used) have sprites queued
+	size_t drawCalls = 0;
+
+	Batch& batchFor(SDL_Texture* texture)
+	{
+		for (size_t i = 0; i < used; i++)
+		{
+			if (batches[i].texture == texture)
+			{
+				return batches[i];
+			}
+		}
+		if (used == batches.size())
+		{
+			batches.push_back(Batch{});
+		}
+		Batch& batch = batches[used++];
+		batch.texture = texture;
+		return batch;
+	}
+
+public:
+	// queues the src part of texture to be drawn at dst, flipping is done by swapping the texture coordinates
+	void draw(SDL_Texture* texture, const SDL_FRect& src, const SDL_FRect& dst, SDL_FlipMode flip = SDL_FLIP_NONE)
+	{
+		float u0 = src.x / texture->w;
+		float v0 = src.y / texture->h;
+		float u1 = (src.x + src.w) / texture->w;
+		float v1 = (src.y + src.h) / texture->h;
+		if (flip & SDL_FLIP_HORIZONTAL)
+		{
+			std::swap(u0, u1);
+		}
+		if (flip & SDL_FLIP_VERTICAL)
+		{
+			std::swap(v0, v1);
+		}
+
+		Batch& batch = batchFor(texture);
+		const int first = static_cast<int>(batch.vertices.size());
+		const SDL_FColor white{ 1.0f, 1.0f, 1.0f, 1.0f };
+		batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y }, white, { u0, v0 } });
+		batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y }, white, { u1, v0 } });
+		batch.vertices.push_back(SDL_Vertex{ { dst.x + dst.w, dst.y + dst.h }, white, { u1, v1 } });
+		batch.vertices.push_back(SDL_Vertex{ { dst.x, dst.y + dst.h }, white, { u0, v1 } });
+		for (int index : { 0, 1, 2, 0, 2, 3 })
+		{
+			batch.indices.push_back(first + index);
+		}
+	}
+	// same as above for the whole texture
+	void draw(SDL_Texture* texture, const SDL_FRect& dst)
+	{
+		draw(texture, SDL_FRect{ 0, 0, static_cast<float>(texture->w), static_cast<float>(texture->h) }, dst);
+	}
+	// src is relative to the region, so sprite sheet frames can be picked the same way as with a standalone texture
+	void draw(const AtlasRegion& region, const SDL_FRect& src, const SDL_FRect& dst, SDL_FlipMode flip = SDL_FLIP_NONE)
+	{
+		draw(region.texture, SDL_FRect{ region.area.x + src.x, region.area.y + src.y, src.w, src.h }, dst, flip);
+	}
+	void draw(const AtlasRegion& region, const SDL_FRect& dst)
+	{
+		draw(region.texture, region.area, dst);
+	}
+
+	// submits everything queued so far without forgetting it, one SDL_RenderGeometry call per texture. Lets a batch
+	// built on one thread be drawn from another, returns how many calls it took
+	size_t submit(SDL_Renderer* renderer) const
+	{
+		for (size_t i = 0; i < used; i++)
+		{
+			const Batch& batch = batches[i];
+			SDL_RenderGeometry(renderer, batch.texture,
+				batch.vertices.data(), static_cast<int>(batch.vertices.size()),
+				batch.indices.data(), static_cast<int>(batch.indices.size()));
+		}
+		return used;
+	}
+	// submits everything queued so far and empties the batch
+	void flush(SDL_Renderer* renderer)
+	{
+		drawCalls += submit(renderer);
+		clear();
+	}
+
+	// throws away everything queued without drawing it
+	void clear()
+	{
+		for (size_t i = 0; i < used; i++)
+		{
+			batches[i].vertices.clear();
+			batches[i].indices.clear();
+		}
+		used = 0;
+	}
+
+	// number of SDL_RenderGeometry calls since the last reset, handy for the debug text
+	size_t getDrawCalls() const { return drawCalls; }
+	void resetDrawCalls() { drawCalls = 0; }
+};
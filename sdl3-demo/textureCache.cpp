@@ -0,0 +1,119 @@
+// textureCache.cpp : Keeps decoded images on disk so warm starts don't have to decode PNGs again.
+//
+
+#include "textureCache.h"
+#include <cstring>
+
+static const uint32_t TEXTURE_CACHE_VERSION = 1;
+
+static uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static bool hashFile(const std::string& path, uint64_t& hash)
+{
+	size_t size = 0;
+	void* contents = SDL_LoadFile(path.c_str(), &size);
+	if (!contents)
+	{
+		return false;
+	}
+	hash = fnv1a(contents, size);
+	SDL_free(contents);
+	return true;
+}
+
+// one file per source image, named after a hash of its path
+static std::string cachePath(const std::string& source)
+{
+	char name[32];
+	SDL_snprintf(name, sizeof(name), "/%016llx.rgba", static_cast<unsigned long long>(fnv1a(source.data(), source.size())));
+	return TEXTURE_CACHE_DIR + std::string(name);
+}
+
+SDL_Surface* readTextureCache(const std::string& source, int padding, std::unique_ptr<MappedFile>& mapping)
+{
+	SDL_PathInfo info;
+	if (!SDL_GetPathInfo(source.c_str(), &info))
+	{
+		return nullptr;
+	}
+	std::unique_ptr<MappedFile> file = std::make_unique<MappedFile>();
+	if (!file->open(cachePath(source)) || file->size() < sizeof(TextureCacheHeader))
+	{
+		return nullptr;
+	}
+	TextureCacheHeader header;
+	std::memcpy(&header, file->data(), sizeof(header));
+	if (std::memcmp(header.magic, "TXC1", 4) != 0 || header.version != TEXTURE_CACHE_VERSION ||
+		header.padding != static_cast<uint32_t>(padding) ||
+		file->size() != sizeof(header) + static_cast<size_t>(header.width) * header.height * 4)
+	{
+		return nullptr;
+	}
+	if (header.sourceModifyTime != info.modify_time || header.sourceSize != info.size)
+	{
+		// touched since the entry was written (checkout, copy...), it's only stale if the contents changed too
+		uint64_t hash;
+		if (!hashFile(source, hash) || hash != header.sourceHash)
+		{
+			return nullptr;
+		}
+	}
+
+	SDL_Surface* surface = SDL_CreateSurfaceFrom(header.width, header.height, SDL_PIXELFORMAT_RGBA32,
+		const_cast<uint8_t*>(file->data() + sizeof(header)), header.width * 4);
+	if (surface)
+	{
+		mapping = std::move(file);
+	}
+	return surface;
+}
+
+bool writeTextureCache(const std::string& source, int padding, SDL_Surface* surface)
+{
+	SDL_PathInfo info;
+	TextureCacheHeader header{};
+	if (!SDL_GetPathInfo(source.c_str(), &info) || !hashFile(source, header.sourceHash) || surface->format != SDL_PIXELFORMAT_RGBA32)
+	{
+		return false;
+	}
+	std::memcpy(header.magic, "TXC1", 4);
+	header.version = TEXTURE_CACHE_VERSION;
+	header.sourceModifyTime = info.modify_time;
+	header.sourceSize = info.size;
+	header.width = surface->w;
+	header.height = surface->h;
+	header.padding = padding;
+
+	SDL_CreateDirectory(TEXTURE_CACHE_DIR);
+	// written under a temporary name first so a crash halfway never leaves a broken entry behind
+	const std::string path = cachePath(source);
+	const std::string temporary = path + ".tmp";
+	SDL_IOStream* io = SDL_IOFromFile(temporary.c_str(), "wb");
+	if (!io)
+	{
+		return false;
+	}
+	bool success = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header);
+	const size_t rowBytes = static_cast<size_t>(surface->w) * 4;
+	for (int y = 0; y < surface->h && success; y++)
+	{
+		const uint8_t* row = static_cast<const uint8_t*>(surface->pixels) + static_cast<size_t>(y) * surface->pitch;
+		success = SDL_WriteIO(io, row, rowBytes) == rowBytes;
+	}
+	success = SDL_CloseIO(io) && success;
+	if (!success || !SDL_RenamePath(temporary.c_str(), path.c_str()))
+	{
+		SDL_RemovePath(temporary.c_str());
+		return false;
+	}
+	return true;
+}
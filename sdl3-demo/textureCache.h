@@ -0,0 +1,33 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <memory>
+#include <string>
+#include "mappedFile.h"
+
+/*
+NOTE: Inflating and unfiltering the same PNGs on every launch is wasted work, so the first time an image gets decoded its
+padded RGBA pixels are also written to cache/textures/. On the next start the cache file is memory mapped and its pixels
+go straight to SDL_UpdateTexture, zlib never runs.
+An entry belongs to one source image and remembers the image's modification time, size and a hash of its contents.
+If the time or size changed the contents are hashed again, an entry that doesn't match anymore is decoded and written
+again like it was never there.
+*/
+const char* const TEXTURE_CACHE_DIR = "cache/textures";
+
+struct TextureCacheHeader
+{
+	char magic[4]; // "TXC1"
+	uint32_t version;
+	int64_t sourceModifyTime;
+	uint64_t sourceSize;
+	uint64_t sourceHash; // FNV-1a over the whole PNG file
+	uint32_t width, height; // of the stored pixels, padding included
+	uint32_t padding;
+	uint32_t reserved[5];
+};
+static_assert(sizeof(TextureCacheHeader) == 64, "pixels start 64 bytes in, keep the header that size");
+
+// surface pointing into the mapped cache entry of source, mapping has to outlive it. nullptr on a miss or a stale entry
+SDL_Surface* readTextureCache(const std::string& source, int padding, std::unique_ptr<MappedFile>& mapping);
+// stores the already padded surface as the cache entry of source
+bool writeTextureCache(const std::string& source, int padding, SDL_Surface* surface);
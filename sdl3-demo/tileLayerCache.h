@@ -0,0 +1,160 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "spriteBatch.h"
+#include "tileMap.h"
+
+/*
+NOTE: Tiles never change once the level is built, but drawing a layer still means queueing one quad per tile every frame.
+The cache bakes each TILE_CHUNK_COLS wide strip of a layer into its own render target texture the first time it is seen,
+after that drawing the layer is one quad per chunk on screen (usually two or three). A chunk only gets baked again when
+the tile map says that part of the layer was edited.
+If the renderer can't give us render targets the chunk is simply drawn tile by tile like before.
+*/
+class TileLayerCache
+{
+	struct Chunk
+	{
+		SDL_Texture* texture;
+		uint32_t revision; // tile map revision baked into the texture, 0 means it was never baked
+		bool empty; // nothing on this layer in this chunk, no texture needed
+	};
+	size_t layer;
+	std::vector<Chunk> chunks;
+	SpriteBatch bakeBatch; // separate from the frame batch so baking never picks up sprites queued for the screen
+	bool targetsSupported = true; // turns false the first time creating a render target fails
+
+	// queues every tile of the chunk, offset moves the chunk's top left corner to where it should end up
+	bool queueTiles(SpriteBatch& batch, const TileMap& tiles, int chunk, float offsetX, float offsetY) const
+	{
+		bool any = false;
+		const int first = chunk * TILE_CHUNK_COLS;
+		const int last = std::min(tiles.getCols(), first + TILE_CHUNK_COLS);
+		for (int r = 0; r < tiles.getRows(); r++)
+		{
+			for (int c = first; c < last; c++)
+			{
+				const uint8_t id = tiles.at(layer, r, c);
+				if (id == 0)
+				{
+					continue;
+				}
+				const AtlasRegion& sprite = tiles.type(id).sprite;
+				SDL_FRect dst = tiles.tileRect(r, c);
+				dst.x += offsetX;
+				dst.y += offsetY;
+				dst.w = sprite.width();
+				dst.h = sprite.height();
+				batch.draw(sprite, dst);
+				any = true;
+			}
+		}
+		return any;
+	}
+	float chunkWidth(const TileMap& tiles) const { return TILE_CHUNK_COLS * tiles.getTileSize(); }
+
+	bool bake(SDL_Renderer* renderer, const TileMap& tiles, int chunk)
+	{
+		Chunk& ch = chunks[chunk];
+		ch.revision = tiles.chunkRevision(layer, chunk);
+		// draw relative to the chunk's top left corner
+		ch.empty = !queueTiles(bakeBatch, tiles, chunk, -chunk * chunkWidth(tiles), -tiles.getOriginY());
+		if (ch.empty)
+		{
+			return true;
+		}
+		if (!ch.texture)
+		{
+			ch.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+				static_cast<int>(chunkWidth(tiles)), static_cast<int>(tiles.getRows() * tiles.getTileSize()));
+			if (!ch.texture)
+			{
+				SDL_Log("Tile cache disabled, could not create a render target: %s", SDL_GetError());
+				bakeBatch.clear();
+				targetsSupported = false;
+				return false;
+			}
+			SDL_SetTextureBlendMode(ch.texture, SDL_BLENDMODE_BLEND);
+			SDL_SetTextureScaleMode(ch.texture, SDL_SCALEMODE_NEAREST);
+		}
+		SDL_Texture* previousTarget = SDL_GetRenderTarget(renderer);
+		SDL_SetRenderTarget(renderer, ch.texture);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+		SDL_RenderClear(renderer);
+		bakeBatch.flush(renderer);
+		SDL_SetRenderTarget(renderer, previousTarget);
+		return true;
+	}
+
+public:
+	TileLayerCache(size_t layer) : layer(layer)
+	{
+	}
+
+	// queues the chunks under visibleArea into batch, baking the ones that are missing or out of date first
+	void draw(SDL_Renderer* renderer, SpriteBatch& batch, const TileMap& tiles, const SDL_FRect& visibleArea, float cameraX)
+	{
+		if (chunks.size() != static_cast<size_t>(tiles.chunkCount()))
+		{
+			// a different map got loaded
+			release();
+			chunks.assign(tiles.chunkCount(), Chunk{ nullptr, 0, false });
+		}
+		if (chunks.empty())
+		{
+			return;
+		}
+		const float width = chunkWidth(tiles);
+		int first, last;
+		tiles.chunkRange(visibleArea, first, last);
+		for (int chunk = first; chunk <= last; chunk++)
+		{
+			Chunk& ch = chunks[chunk];
+			if (!targetsSupported || (ch.revision != tiles.chunkRevision(layer, chunk) && !bake(renderer, tiles, chunk)))
+			{
+				queueTiles(batch, tiles, chunk, -cameraX, 0);
+				continue;
+			}
+			if (ch.empty)
+			{
+				continue;
+			}
+			const SDL_FRect dst{
+				.x = chunk * width - cameraX,
+				.y = tiles.getOriginY(),
+				.w = static_cast<float>(ch.texture->w),
+				.h = static_cast<float>(ch.texture->h)
+			};
+			batch.draw(ch.texture, dst);
+		}
+	}
+
+	// render target contents are gone (SDL_EVENT_RENDER_TARGETS_RESET), bake everything again when it is next seen
+	void invalidate()
+	{
+		for (Chunk& ch : chunks)
+		{
+			ch.revision = 0;
+		}
+	}
+	// the chunk's tiles were unloaded, its texture comes back when it gets baked again
+	void releaseChunk(int chunk)
+	{
+		if (static_cast<size_t>(chunk) < chunks.size())
+		{
+			SDL_DestroyTexture(chunks[chunk].texture);
+			chunks[chunk] = Chunk{ nullptr, 0, false };
+		}
+	}
+	// call before the renderer is destroyed
+	void release()
+	{
+		for (Chunk& ch : chunks)
+		{
+			SDL_DestroyTexture(ch.texture);
+		}
+		chunks.clear();
+	}
+};
@@ -0,0 +1,187 @@
+#pragma once
+#include <SDL3/SDL.h>
+#include "atlas.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+const size_t TILE_LAYER_BACKGROUND = 0;
+const size_t TILE_LAYER_LEVEL = 1; // the only layer that can be collided with
+const size_t TILE_LAYER_FOREGROUND = 2;
+const size_t TILE_LAYER_COUNT = 3;
+const int TILE_CHUNK_COLS = 16; // columns per chunk, edits are tracked per chunk so caches know what to redraw
+
+// everything the game needs to know about one kind of tile, cells only store an index into the table
+struct TileType
+{
+	AtlasRegion sprite;
+	bool solid;
+};
+
+/*
+NOTE: Tiles never move, so there is no reason for each one to be a full entity with its own position and collider.
+The map stores one byte per cell for each layer. A tile's position comes from its row/column, and collision works
+by looking up the handful of cells under a hitbox, so the cost doesn't depend on how big the level is.
+Cells are kept per chunk (TILE_CHUNK_COLS wide, every layer and row of it in one block), so parts of a long level can be
+loaded and dropped independently, see levelStreamer.h. A chunk that isn't loaded reads as empty everywhere.
+*/
+class TileMap
+{
+	int rows, cols;
+	float tileSize;
+	float originY; // world y of the top row
+	std::vector<std::vector<uint8_t>> chunks; // [layer][row][column inside the chunk], empty while the chunk isn't loaded
+	std::array<std::vector<uint32_t>, TILE_LAYER_COUNT> revisions; // bumped every time a chunk of a layer is edited
+	std::vector<TileType> types; // index 0 is always the empty tile
+
+	size_t cellIndex(size_t layer, int r, int c) const
+	{
+		return (layer * rows + r) * TILE_CHUNK_COLS + c % TILE_CHUNK_COLS;
+	}
+	void touchChunk(int chunk)
+	{
+		for (std::vector<uint32_t>& layer : revisions)
+		{
+			layer[chunk]++;
+		}
+	}
+
+public:
+	TileMap() : rows(0), cols(0), tileSize(0), originY(0)
+	{
+		types.push_back(TileType{ AtlasRegion(), false });
+	}
+	// loaded = false starts with every chunk unloaded, they have to be handed in with loadChunk()
+	TileMap(int rows, int cols, float tileSize, float originY, bool loaded = true) : rows(rows), cols(cols), tileSize(tileSize), originY(originY)
+	{
+		chunks.resize(chunkCount());
+		if (loaded)
+		{
+			for (std::vector<uint8_t>& chunk : chunks)
+			{
+				chunk.assign(chunkCellCount(), 0);
+			}
+		}
+		for (std::vector<uint32_t>& layer : revisions)
+		{
+			layer.assign(chunkCount(), 1); // caches start at 0 so everything gets drawn the first time
+		}
+		types.push_back(TileType{ AtlasRegion(), false });
+	}
+
+	void setType(uint8_t id, const TileType& type)
+	{
+		if (id >= types.size())
+		{
+			types.resize(id + 1, TileType{ AtlasRegion(), false });
+		}
+		types[id] = type;
+		// a new texture can show up anywhere in the map
+		for (std::vector<uint32_t>& layer : revisions)
+		{
+			for (uint32_t& revision : layer)
+			{
+				revision++;
+			}
+		}
+	}
+	const TileType& type(uint8_t id) const { return types[id]; }
+	size_t typeCount() const { return types.size(); }
+
+	uint8_t at(size_t layer, int r, int c) const
+	{
+		const std::vector<uint8_t>& chunk = chunks[c / TILE_CHUNK_COLS];
+		return chunk.empty() ? 0 : chunk[cellIndex(layer, r, c)];
+	}
+	// only works on loaded chunks, edits to a chunk that isn't loaded are dropped
+	void set(size_t layer, int r, int c, uint8_t id)
+	{
+		std::vector<uint8_t>& chunk = chunks[c / TILE_CHUNK_COLS];
+		if (!chunk.empty())
+		{
+			chunk[cellIndex(layer, r, c)] = id;
+			revisions[layer][c / TILE_CHUNK_COLS]++;
+		}
+	}
+
+	// bytes in the cell block of one chunk, laid out [layer][row][TILE_CHUNK_COLS]
+	size_t chunkCellCount() const { return TILE_LAYER_COUNT * rows * TILE_CHUNK_COLS; }
+	bool isLoaded(int chunk) const { return !chunks[chunk].empty(); }
+	// the cell block of chunk, empty if it isn't loaded
+	const std::vector<uint8_t>& chunkCells(int chunk) const { return chunks[chunk]; }
+	// swaps cells (chunkCellCount() bytes) in as the contents of chunk, cells gets the old block back so it can be reused
+	void loadChunk(int chunk, std::vector<uint8_t>& cells)
+	{
+		chunks[chunk].swap(cells);
+		touchChunk(chunk);
+	}
+	// hands the chunk's block to cells and leaves the chunk empty
+	void unloadChunk(int chunk, std::vector<uint8_t>& cells)
+	{
+		cells.swap(chunks[chunk]);
+		std::vector<uint8_t>().swap(chunks[chunk]); // don't keep whatever cells held before around
+		touchChunk(chunk);
+	}
+	bool isSolid(int r, int c) const
+	{
+		if (r < 0 || r >= rows || c < 0 || c >= cols)
+		{
+			return false;
+		}
+		return types[at(TILE_LAYER_LEVEL, r, c)].solid;
+	}
+
+	int getRows() const { return rows; }
+	int getCols() const { return cols; }
+	float getTileSize() const { return tileSize; }
+	float getOriginY() const { return originY; }
+	float width() const { return cols * tileSize; }
+	int chunkCount() const { return (cols + TILE_CHUNK_COLS - 1) / TILE_CHUNK_COLS; }
+	uint32_t chunkRevision(size_t layer, int chunk) const { return revisions[layer][chunk]; }
+
+	SDL_FRect tileRect(int r, int c) const
+	{
+		return SDL_FRect{
+			.x = c * tileSize,
+			.y = originY + r * tileSize,
+			.w = tileSize,
+			.h = tileSize
+		};
+	}
+	// rows/columns touched by rect, clamped to the map (r0 > r1 or c0 > c1 means nothing is touched)
+	void cellRange(const SDL_FRect& rect, int& r0, int& c0, int& r1, int& c1) const
+	{
+		c0 = std::max(0, static_cast<int>(std::floor(rect.x / tileSize)));
+		c1 = std::min(cols - 1, static_cast<int>(std::floor((rect.x + rect.w) / tileSize)));
+		r0 = std::max(0, static_cast<int>(std::floor((rect.y - originY) / tileSize)));
+		r1 = std::min(rows - 1, static_cast<int>(std::floor((rect.y + rect.h - originY) / tileSize)));
+	}
+
+	// chunks touched by rect, clamped to the map (first > last means none)
+	void chunkRange(const SDL_FRect& rect, int& first, int& last) const
+	{
+		const float width = TILE_CHUNK_COLS * tileSize;
+		first = std::max(0, static_cast<int>(std::floor(rect.x / width)));
+		last = std::min(chunkCount() - 1, static_cast<int>(std::floor((rect.x + rect.w) / width)));
+	}
+
+	// calls f(tileRect) for every solid tile in the cells under rect
+	template<typename F>
+	void forEachSolid(const SDL_FRect& rect, F f) const
+	{
+		int r0, c0, r1, c1;
+		cellRange(rect, r0, c0, r1, c1);
+		for (int r = r0; r <= r1; r++)
+		{
+			for (int c = c0; c <= c1; c++)
+			{
+				if (types[at(TILE_LAYER_LEVEL, r, c)].solid)
+				{
+					f(tileRect(r, c));
+				}
+			}
+		}
+	}
+};